@@ -0,0 +1,65 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <random>
+
+
+template<unsigned char n>
+tmm::Matrix<n,n,float> random(){
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    tmm::Matrix<n,n,float> r;
+    for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) r.data[i][j] = dist(rng);
+    return r;
+}
+
+// The i-j-k loop that operator* uses below the blocking threshold
+template<unsigned char n>
+void naive_product(const tmm::Matrix<n,n,float> &A, const tmm::Matrix<n,n,float> &B, tmm::Matrix<n,n,float> &C){
+    for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+    for(int k = 0; k < n; k++)
+    C.data[i][j] += A.data[i][k] * B.data[k][j];
+}
+
+// Compares the naive loop with operator*, which selects the blocked kernel for these sizes
+template<unsigned char n>
+void benchmark_gemm(){
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    // Run enough trials that each size takes a similar amount of time
+    const int num_trials = 1 + 20000000 / (n*n*n);
+    const double flops = 2.0 * n * n * n * num_trials;
+
+    tmm::Matrix<n,n,float> A = random<n>();
+    tmm::Matrix<n,n,float> B = random<n>();
+    tmm::Matrix<n,n,float> C;
+
+    auto t1 = high_resolution_clock::now();
+    for(int i = 0; i < num_trials; i++) naive_product<n>(A, B, C);
+    auto t2 = high_resolution_clock::now();
+    for(int i = 0; i < num_trials; i++) C = A * B;
+    auto t3 = high_resolution_clock::now();
+
+    duration<double> naive   = t2 - t1;
+    duration<double> blocked = t3 - t2;
+
+    std::cout << (int)n << "x" << (int)n
+              << "\tnaive: "   << flops / naive.count()   * 1e-9 << " GFLOP/s"
+              << "\toperator*: " << flops / blocked.count() * 1e-9 << " GFLOP/s"
+              << "\tspeedup: " << naive.count() / blocked.count() << "x"
+              << "\t(checksum " << C.data[n/2][n/2] << ")\n";
+}
+
+
+int  main() {
+  benchmark_gemm<32>();
+  benchmark_gemm<64>();
+  benchmark_gemm<96>();
+  benchmark_gemm<128>();
+  benchmark_gemm<200>();
+  benchmark_gemm<255>();
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+
+template<unsigned char n>
+tmm::Matrix<n,n,double> random(){
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<double> dist(-1, 1);
+    tmm::Matrix<n,n,double> r;
+    for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) r.data[i][j] = dist(rng);
+    return r;
+}
+
+// Returns the average number of seconds taken by one call to f
+template<typename F>
+double time_it(int num_trials, F f){
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < num_trials; i++) f();
+    auto t2 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(t2 - t1).count() / num_trials;
+}
+
+// Times a product, an LU decomposition and a Cholesky decomposition of n x n matrices
+template<unsigned char n>
+void benchmark_size(){
+    const int num_trials = 1 + 20000000 / (n*n*n);
+
+    tmm::Matrix<n,n,double> A = random<n>();
+    tmm::Matrix<n,n,double> B = random<n>();
+    tmm::Matrix<n,n,double> SPD = A * A.transpose() + tmm::Identity<n,double>() * n;
+    tmm::Matrix<n,n,double> C;
+    unsigned char pivots[n];
+
+    double product  = time_it(num_trials, [&]{ C = A * B; });
+    double lu       = time_it(num_trials, [&]{ C = A; tmm::luDecompose(C, pivots); });
+    double cholesky = time_it(num_trials, [&]{ C = SPD; tmm::choleskyDecompose(C); });
+
+    std::cout << (int)n << "x" << (int)n
+              << "\toperator*: " << 2.0*n*n*n       / product  * 1e-9 << " GFLOP/s"
+              << "\tLU: "        << 2.0/3.0*n*n*n   / lu       * 1e-9 << " GFLOP/s"
+              << "\tCholesky: "  << 1.0/3.0*n*n*n   / cholesky * 1e-9 << " GFLOP/s\n";
+}
+
+
+int  main() {
+#ifdef TMM_ENABLE_THREADS
+  unsigned int max_threads = std::thread::hardware_concurrency();
+  if(max_threads == 0) max_threads = 1;
+  for(unsigned int threads = 1; ; threads *= 2){
+    if(threads > max_threads) threads = max_threads;
+    tmm::ThreadPool::shared().resize(threads);
+    std::cout << "---------------------------- " << threads << " thread(s) -------------------------" << std::endl;
+    benchmark_size<64>();
+    benchmark_size<128>();
+    benchmark_size<200>();
+    benchmark_size<255>();
+    if(threads == max_threads) break;
+  }
+#else
+  std::cout << "Threading is disabled; configure with -Dtinymatrixmath_ENABLE_THREADS=ON to measure scaling." << std::endl;
+  std::cout << "---------------------------- 1 thread -------------------------" << std::endl;
+  benchmark_size<64>();
+  benchmark_size<128>();
+  benchmark_size<200>();
+  benchmark_size<255>();
+#endif
+  return 0;
+}
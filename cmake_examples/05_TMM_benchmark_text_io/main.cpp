@@ -0,0 +1,71 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+
+// The way printTo(std::ostream&) used to work: setw-formatted operator<< and std::endl after every row
+template<unsigned char n, unsigned char m>
+void print_unbuffered(const tmm::Matrix<n,m,float> &M, std::ostream &out){
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < m; j++) out << std::setw(6) << M.data[i][j] << "\t";
+        out << std::endl;
+    }
+}
+
+double seconds_since(std::chrono::high_resolution_clock::time_point t){
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t).count();
+}
+
+
+// Writes a log of 6x6 matrices with both paths, then parses it back
+int  main() {
+    const int num_matrices = 100000;
+    const char *path = "TMM_05_benchmark_text_io.tsv";
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-100, 100);
+    std::vector<tmm::Matrix<6,6,float>> matrices(num_matrices);
+    for(auto &M : matrices) for(int i = 0; i < 6; i++) for(int j = 0; j < 6; j++) M.data[i][j] = dist(rng);
+
+    auto t = std::chrono::high_resolution_clock::now();
+    {
+        std::ofstream file(path);
+        for(const auto &M : matrices) print_unbuffered(M, file);
+    }
+    const double old_write = seconds_since(t);
+
+    t = std::chrono::high_resolution_clock::now();
+    {
+        std::ofstream file(path);
+        tmm::TextWriter writer(file);
+        for(const auto &M : matrices) M.formatTo(writer);
+    }
+    const double new_write = seconds_since(t);
+
+    std::ifstream size_check(path, std::ios::ate | std::ios::binary);
+    const double megabytes = size_check.tellg() / 1e6;
+
+    t = std::chrono::high_resolution_clock::now();
+    int read = 0;
+    bool exact = true;
+    {
+        std::ifstream file(path);
+        tmm::TextReader reader(file);
+        tmm::Matrix<6,6,float> M;
+        while(M.readFrom(reader)) exact = exact && (M == matrices[read++]);
+    }
+    const double new_read = seconds_since(t);
+
+    std::cout << "setw + std::endl write: " << old_write << " s\n";
+    std::cout << "TextWriter write:       " << new_write << " s (" << megabytes / new_write << " MB/s)\n";
+    std::cout << "TextReader read:        " << new_read  << " s (" << megabytes / new_read  << " MB/s), "
+              << read << " matrices, " << (exact ? "exact round trip" : "MISMATCH") << "\n";
+
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+
+// A synthetic ground-station stream: raw 16-sample frames are decoded into a 6-element state
+// measurement, smoothed by a constant-gain filter, rotated into another frame, and summed.
+typedef tmm::Matrix<16,1> Raw;
+typedef tmm::Matrix<6,1>  State;
+
+const int num_frames = 200000;
+
+struct Model{
+    tmm::Matrix<6,16> decoder;
+    tmm::Matrix<6,6>  F, K, R;
+
+    Model(){
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+        for(int i = 0; i < 6; i++) for(int j = 0; j < 16; j++) decoder.data[i][j] = dist(rng);
+        for(int i = 0; i < 6; i++) for(int j = 0; j < 6; j++){
+            F.data[i][j] = (i == j ? 1.0f : 0.0f) + 0.01f * dist(rng);
+            K.data[i][j] = i == j ? 0.2f : 0.0f;
+            R.data[i][j] = dist(rng);
+        }
+    }
+};
+
+// Synthetic source: a deterministic sequence of raw frames
+struct Source{
+    int next = 0;
+    bool operator()(Raw &frame){
+        if(next == num_frames) return false;
+        for(int i = 0; i < 16; i++) frame.data[i][0] = (float)((next * 7 + i * 13) % 101) * 0.01f;
+        next++;
+        return true;
+    }
+};
+
+
+double seconds_since(std::chrono::high_resolution_clock::time_point t){
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t).count();
+}
+
+
+// The same work as a single sequential loop
+double sequential(const Model &model, float &checksum){
+    auto t = std::chrono::high_resolution_clock::now();
+    Source source;
+    Raw raw;
+    State x, z, y;
+    checksum = 0;
+    while(source(raw)){
+        z = model.decoder * raw;
+        x = model.F * x;
+        x = x + model.K * (z - x);
+        y = model.R * x;
+        for(int i = 0; i < 6; i++) checksum += y.data[i][0];
+    }
+    return seconds_since(t);
+}
+
+
+#ifdef TMM_ENABLE_THREADS
+double pipelined(const Model &model, std::size_t batch, float &checksum){
+    auto t = std::chrono::high_resolution_clock::now();
+    tmm::Pipeline pipeline(256, batch);
+    State x;
+    checksum = 0;
+
+    auto &raw = pipeline.source<Raw>("source", Source());
+    auto &measured = pipeline.stage<State>("decode", raw, [&](const Raw &in, State &out){
+        out = model.decoder * in;
+        return true;
+    });
+    auto &filtered = pipeline.stage<State>("filter", measured, [&](const State &z, State &out){
+        x = model.F * x;
+        x = x + model.K * (z - x);
+        out = x;
+        return true;
+    });
+    auto &rotated = pipeline.stage<State>("transform", filtered, [&](const State &in, State &out){
+        out = model.R * in;
+        return true;
+    });
+    pipeline.sink("write", rotated, [&](const State &y){
+        for(int i = 0; i < 6; i++) checksum += y.data[i][0];
+    });
+
+    pipeline.start();
+    pipeline.wait();
+    const double seconds = seconds_since(t);
+
+    std::cout << "  batch " << std::setw(3) << batch << ": " << std::setw(9) << num_frames / seconds << " frames/s\n";
+    for(const tmm::PipelineStageStats &s : pipeline.stats()){
+        std::cout << "    " << std::left << std::setw(10) << s.name << std::right
+                  << std::setw(10) << (long)s.throughput << " frames/s"
+                  << "  busy " << std::setw(7) << s.busySeconds * 1e3 << " ms"
+                  << "  latency mean " << std::setw(8) << s.meanLatency * 1e6 << " us"
+                  << ", max " << std::setw(8) << s.maxLatency * 1e6 << " us"
+                  << "  stalls " << s.stalls << ", starves " << s.starves << "\n";
+    }
+    return seconds;
+}
+#endif
+
+
+int  main() {
+    Model model;
+    float expected;
+    const double loop = sequential(model, expected);
+    std::cout << "Sequential loop: " << num_frames / loop << " frames/s (checksum " << expected << ")\n";
+
+#ifdef TMM_ENABLE_THREADS
+    std::cout << "Pipeline with one thread per stage (" << std::thread::hardware_concurrency() << " hardware threads):\n";
+    for(std::size_t batch : {1, 8, 64}){
+        float checksum;
+        pipelined(model, batch, checksum);
+        if(checksum != expected) std::cout << "  checksum mismatch: " << checksum << "\n";
+    }
+#else
+    std::cout << "Threading is disabled; configure with -Dtinymatrixmath_ENABLE_THREADS=ON to run the pipeline." << std::endl;
+#endif
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <random>
+
+
+template<unsigned char n>
+tmm::Matrix<n,n,float> random(){
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<float> dist(-1, 1);
+    tmm::Matrix<n,n,float> r;
+    for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) r.data[i][j] = dist(rng);
+    return r;
+}
+
+// A single running sum, where every addition waits for the one before it
+template<unsigned char n>
+float naive_dot(const tmm::Matrix<n,n,float> &A, const tmm::Matrix<n,n,float> &B){
+    float s = 0;
+    for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+    s += A.data[i][j] * B.data[i][j];
+    return s;
+}
+
+// Compares the naive dot product with tmm::dot in each summation mode.
+// The error is measured against a double-precision sum.
+template<unsigned char n>
+void benchmark_dot(){
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const int num_trials = 1 + 50000000 / (n*n);
+    const double flops = 2.0 * n * n * num_trials;
+
+    tmm::Matrix<n,n,float> A = random<n>();
+    tmm::Matrix<n,n,float> B = random<n>();
+    double exact = 0;
+    for(int i = 0; i < n; i++) for(int j = 0; j < n; j++) exact += (double)A.data[i][j] * B.data[i][j];
+
+    const char *names[] = {"naive", "lanes", "kahan", "pairwise"};
+    std::cout << (int)n << "x" << (int)n;
+    for(int mode = 0; mode < 4; mode++){
+        volatile float result = 0;
+        auto t1 = high_resolution_clock::now();
+        for(int i = 0; i < num_trials; i++){
+            // Perturb an input so the compiler can't hoist the reduction out of the loop
+            A.data[0][0] += 0.0f * result;
+            result = mode == 0 ? naive_dot<n>(A, B) : tmm::dot(A, B, (tmm::Summation)(mode - 1));
+        }
+        auto t2 = high_resolution_clock::now();
+        duration<double> time = t2 - t1;
+        std::cout << "\t" << names[mode] << ": " << flops / time.count() * 1e-9 << " GFLOP/s"
+                  << " (error " << std::abs(result - exact) << ")";
+    }
+    std::cout << "\n";
+}
+
+
+int  main() {
+  benchmark_dot<16>();
+  benchmark_dot<64>();
+  benchmark_dot<128>();
+  benchmark_dot<255>();
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include <TinyMatrixMath.hpp>
+
+#include <chrono>
+#include <random>
+
+
+template<unsigned char n, unsigned char m>
+tmm::Matrix<n,m,float> random(float lo, float hi){
+    std::random_device dev;
+    std::mt19937 rng(dev());
+    std::uniform_real_distribution<float> dist(lo, hi);
+    tmm::Matrix<n,m,float> r;
+    for(int i = 0; i < n; i++) for(int j = 0; j < m; j++) r.data[i][j] = dist(rng);
+    return r;
+}
+
+// The float layer relu(W x + bias)
+template<unsigned char n, unsigned char m, unsigned char q>
+void float_layer(const tmm::Matrix<n,m,float> &W, const tmm::Matrix<m,q,float> &X, const float bias[n], tmm::Matrix<n,q,float> &Y){
+    Y = W * X;
+    for(int i = 0; i < n; i++)
+    for(int j = 0; j < q; j++){
+        const float y = Y.data[i][j] + bias[i];
+        Y.data[i][j] = y > 0 ? y : 0;
+    }
+}
+
+// Compares a dense layer on floats with the same layer on int8 weights and activations.
+// The error is the largest difference between the two outputs, in output quantization steps.
+template<unsigned char n, unsigned char m, unsigned char q>
+void benchmark_layer(){
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration;
+
+    const int num_trials = 1 + 100000000 / (n*m*q);
+    const double ops = 2.0 * n * m * q * num_trials;
+
+    const tmm::Matrix<n,m,float> W = random<n,m>(-0.1f, 0.1f);
+    tmm::Matrix<m,q,float> X = random<m,q>(0, 1);
+    const tmm::Matrix<n,1,float> bias = random<n,1>(-0.5f, 0.5f);
+    tmm::Matrix<n,q,float> Y;
+
+    const tmm::Quantization w_quant = tmm::quantizationForRange(-0.1f, 0.1f);
+    const tmm::Quantization x_quant = tmm::quantizationForRange(0, 1);
+    const tmm::Quantization y_quant = tmm::quantizationForRange(0, 4);
+    const tmm::Matrix<n,m,int8_t> Wq = tmm::quantize(W, w_quant);
+    tmm::Matrix<m,q,int8_t> Xq = tmm::quantize(X, x_quant);
+    const tmm::Requantization<n> layer(Wq, w_quant, x_quant, y_quant, &bias.data[0][0], true);
+    tmm::Matrix<n,q,int8_t> Yq;
+
+    // Feed one output element back into the input so the compiler can't hoist the layer out of the loop
+    auto t1 = high_resolution_clock::now();
+    for(int i = 0; i < num_trials; i++){
+        float_layer<n,m,q>(W, X, &bias.data[0][0], Y);
+        X.data[0][0] = Y.data[0][0] * 0.0f;
+    }
+    auto t2 = high_resolution_clock::now();
+    for(int i = 0; i < num_trials; i++){
+        Yq = tmm::quantizedMultiply(Wq, Xq, layer);
+        Xq.data[0][0] = (int8_t)(Yq.data[0][0] & 0);
+    }
+    auto t3 = high_resolution_clock::now();
+
+    float error = 0;
+    const tmm::Matrix<n,q,float> Y_int8 = tmm::dequantize(Yq, y_quant);
+    for(int i = 0; i < n; i++) for(int j = 0; j < q; j++){
+        const float e = std::abs(Y_int8.data[i][j] - Y.data[i][j]) / y_quant.scale;
+        error = e > error ? e : error;
+    }
+
+    duration<double> float_time = t2 - t1;
+    duration<double> int8_time  = t3 - t2;
+    std::cout << (int)n << "x" << (int)m << " * " << (int)m << "x" << (int)q
+              << "\tfloat: " << ops / float_time.count() * 1e-9 << " GOP/s"
+              << "\tint8: "  << ops / int8_time.count()  * 1e-9 << " GOP/s"
+              << "\tspeedup: " << float_time.count() / int8_time.count() << "x"
+              << "\tweights: " << sizeof(W) << " -> " << sizeof(Wq) << " bytes"
+              << "\t(error " << error << " steps)\n";
+}
+
+
+int  main() {
+  benchmark_layer<32,32,1>();
+  benchmark_layer<128,128,1>();
+  benchmark_layer<255,255,1>();
+  benchmark_layer<64,64,8>();
+  benchmark_layer<128,128,16>();
+  return 0;
+}
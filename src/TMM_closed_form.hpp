@@ -0,0 +1,173 @@
+// Closed-form determinants and inverses of 2x2, 3x3 and 4x4 matrices.
+//
+// Matrix::determinant() and Matrix::inverse() use these instead of cofactor
+// expansion for the sizes that come up most: rotations, homogeneous transforms
+// and small covariances. The determinant and the adjugate share their 2x2
+// (and, for 3x3, cofactor) terms, so an inverse costs little more than a determinant.
+// None of them branch: inverse() always fills its result and returns false if
+// the determinant is zero, in which case the result holds infinities or NaNs.
+//
+// This file is included at the end of TMM_matrix.hpp.
+
+#pragma once
+
+
+namespace tmm{
+
+
+    // Only 2x2, 3x3 and 4x4 matrices have closed-form specializations
+    template<Size n, typename Scalar>
+    struct ClosedForm{};
+
+
+    template<typename Scalar>
+    struct ClosedForm<2,Scalar>{
+
+        static Scalar
+        determinant(const Matrix<2,2,Scalar> &A)
+        {
+            return A.data[0][0]*A.data[1][1] - A.data[0][1]*A.data[1][0];
+        }
+
+        static bool
+        inverse(const Matrix<2,2,Scalar> &A, Matrix<2,2,Scalar> &result)
+        {
+            const Scalar det = determinant(A);
+            const Scalar r = 1 / det;
+            const Scalar a = A.data[0][0], b = A.data[0][1];
+            const Scalar c = A.data[1][0], d = A.data[1][1];
+            result.data[0][0] =  d*r;  result.data[0][1] = -b*r;
+            result.data[1][0] = -c*r;  result.data[1][1] =  a*r;
+            return det != 0;
+        }
+    };
+
+
+    template<typename Scalar>
+    struct ClosedForm<3,Scalar>{
+
+        static Scalar
+        determinant(const Matrix<3,3,Scalar> &A)
+        {
+            const Scalar (&a)[3][3] = A.data;
+            return a[0][0]*(a[1][1]*a[2][2] - a[1][2]*a[2][1])
+                 + a[0][1]*(a[1][2]*a[2][0] - a[1][0]*a[2][2])
+                 + a[0][2]*(a[1][0]*a[2][1] - a[1][1]*a[2][0]);
+        }
+
+        static bool
+        inverse(const Matrix<3,3,Scalar> &A, Matrix<3,3,Scalar> &result)
+        {
+            const Scalar (&a)[3][3] = A.data;
+            // Cofactors of the first row, shared with the determinant
+            const Scalar c00 = a[1][1]*a[2][2] - a[1][2]*a[2][1];
+            const Scalar c01 = a[1][2]*a[2][0] - a[1][0]*a[2][2];
+            const Scalar c02 = a[1][0]*a[2][1] - a[1][1]*a[2][0];
+            const Scalar det = a[0][0]*c00 + a[0][1]*c01 + a[0][2]*c02;
+            const Scalar r = 1 / det;
+
+            Scalar (&b)[3][3] = result.data;
+            b[0][0] = c00*r;
+            b[1][0] = c01*r;
+            b[2][0] = c02*r;
+            b[0][1] = (a[0][2]*a[2][1] - a[0][1]*a[2][2])*r;
+            b[1][1] = (a[0][0]*a[2][2] - a[0][2]*a[2][0])*r;
+            b[2][1] = (a[0][1]*a[2][0] - a[0][0]*a[2][1])*r;
+            b[0][2] = (a[0][1]*a[1][2] - a[0][2]*a[1][1])*r;
+            b[1][2] = (a[0][2]*a[1][0] - a[0][0]*a[1][2])*r;
+            b[2][2] = (a[0][0]*a[1][1] - a[0][1]*a[1][0])*r;
+            return det != 0;
+        }
+    };
+
+
+    template<typename Scalar>
+    struct ClosedForm<4,Scalar>{
+
+        // The 2x2 determinants of the top two rows (s) and the bottom two rows (c).
+        // Every 3x3 cofactor is a combination of one row element and three of these.
+        struct Minors{
+            Scalar s0, s1, s2, s3, s4, s5;
+            Scalar c0, c1, c2, c3, c4, c5;
+
+            explicit Minors(const Scalar (&a)[4][4]):
+                s0(a[0][0]*a[1][1] - a[1][0]*a[0][1]),
+                s1(a[0][0]*a[1][2] - a[1][0]*a[0][2]),
+                s2(a[0][0]*a[1][3] - a[1][0]*a[0][3]),
+                s3(a[0][1]*a[1][2] - a[1][1]*a[0][2]),
+                s4(a[0][1]*a[1][3] - a[1][1]*a[0][3]),
+                s5(a[0][2]*a[1][3] - a[1][2]*a[0][3]),
+                c0(a[2][0]*a[3][1] - a[3][0]*a[2][1]),
+                c1(a[2][0]*a[3][2] - a[3][0]*a[2][2]),
+                c2(a[2][0]*a[3][3] - a[3][0]*a[2][3]),
+                c3(a[2][1]*a[3][2] - a[3][1]*a[2][2]),
+                c4(a[2][1]*a[3][3] - a[3][1]*a[2][3]),
+                c5(a[2][2]*a[3][3] - a[3][2]*a[2][3])
+            {}
+
+            Scalar
+            determinant() const
+            {
+                return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+            }
+        };
+
+        static Scalar
+        determinant(const Matrix<4,4,Scalar> &A)
+        {
+            return Minors(A.data).determinant();
+        }
+
+        static bool
+        inverse(const Matrix<4,4,Scalar> &A, Matrix<4,4,Scalar> &result)
+        {
+            const Scalar (&a)[4][4] = A.data;
+            const Minors m(a);
+            const Scalar det = m.determinant();
+            const Scalar r = 1 / det;
+
+            Scalar (&b)[4][4] = result.data;
+            b[0][0] = ( a[1][1]*m.c5 - a[1][2]*m.c4 + a[1][3]*m.c3)*r;
+            b[0][1] = (-a[0][1]*m.c5 + a[0][2]*m.c4 - a[0][3]*m.c3)*r;
+            b[0][2] = ( a[3][1]*m.s5 - a[3][2]*m.s4 + a[3][3]*m.s3)*r;
+            b[0][3] = (-a[2][1]*m.s5 + a[2][2]*m.s4 - a[2][3]*m.s3)*r;
+
+            b[1][0] = (-a[1][0]*m.c5 + a[1][2]*m.c2 - a[1][3]*m.c1)*r;
+            b[1][1] = ( a[0][0]*m.c5 - a[0][2]*m.c2 + a[0][3]*m.c1)*r;
+            b[1][2] = (-a[3][0]*m.s5 + a[3][2]*m.s2 - a[3][3]*m.s1)*r;
+            b[1][3] = ( a[2][0]*m.s5 - a[2][2]*m.s2 + a[2][3]*m.s1)*r;
+
+            b[2][0] = ( a[1][0]*m.c4 - a[1][1]*m.c2 + a[1][3]*m.c0)*r;
+            b[2][1] = (-a[0][0]*m.c4 + a[0][1]*m.c2 - a[0][3]*m.c0)*r;
+            b[2][2] = ( a[3][0]*m.s4 - a[3][1]*m.s2 + a[3][3]*m.s0)*r;
+            b[2][3] = (-a[2][0]*m.s4 + a[2][1]*m.s2 - a[2][3]*m.s0)*r;
+
+            b[3][0] = (-a[1][0]*m.c3 + a[1][1]*m.c1 - a[1][2]*m.c0)*r;
+            b[3][1] = ( a[0][0]*m.c3 - a[0][1]*m.c1 + a[0][2]*m.c0)*r;
+            b[3][2] = (-a[3][0]*m.s3 + a[3][1]*m.s1 - a[3][2]*m.s0)*r;
+            b[3][3] = ( a[2][0]*m.s3 - a[2][1]*m.s1 + a[2][2]*m.s0)*r;
+            return det != 0;
+        }
+    };
+
+
+    /// @brief Inverts a rigid 4x4 homogeneous transform [R t; 0 0 0 1], where R is a rotation
+    /// @param T the transform to invert
+    /// @return [R^T -R^T*t; 0 0 0 1]
+    /// @warning This assumes R is orthonormal and the last row is [0 0 0 1]; it doesn't check either.
+    template<typename Scalar>
+    Matrix<4,4,Scalar>
+    rigidTransformInverse(const Matrix<4,4,Scalar> &T)
+    {
+        Matrix<4,4,Scalar> result;
+        const Scalar (&a)[4][4] = T.data;
+        Scalar (&b)[4][4] = result.data;
+        for(Size i = 0; i < 3; i++){
+            for(Size j = 0; j < 3; j++) b[i][j] = a[j][i];
+            b[i][3] = -(a[0][i]*a[0][3] + a[1][i]*a[1][3] + a[2][i]*a[2][3]);
+        }
+        b[3][3] = 1;
+        return result;
+    }
+
+}
@@ -0,0 +1,257 @@
+// LU and Cholesky factorizations of square matrices, solvers that use them,
+// and rank-1 updates of a Cholesky factor.
+//
+// Both factorizations are blocked: each step factors a TMM_DECOMPOSITION_BLOCK-wide
+// panel with a simple loop, then applies the panel to the trailing matrix with
+// a single matrix-matrix product. For matrices smaller than the block size this
+// is the textbook algorithm. For large matrices the trailing update uses the
+// blocked kernel in TMM_gemm.hpp. When TMM_ENABLE_THREADS is defined, the updates of
+// matrices large enough for useThreadedFactorization() run on the shared thread pool.
+
+#pragma once
+
+#include <math.h>
+#include "TMM_matrix.hpp"
+
+#ifndef TMM_DECOMPOSITION_BLOCK
+    #define TMM_DECOMPOSITION_BLOCK 32
+#endif
+
+
+namespace tmm{
+
+
+    /// @brief Factors a square matrix in place as P*A = L*U, using partial pivoting
+    /// @param A the matrix to factor. On return, it holds U on and above the diagonal,
+    /// and the unit lower-triangular L (without its diagonal) below it.
+    /// @param pivots on return, row i of A was swapped with row pivots[i] at step i
+    /// @return false if the matrix is singular, in which case A is only partially factored
+    template<Size n, typename Scalar>
+    bool
+    luDecompose(Matrix<n,n,Scalar> &A, Size pivots[n])
+    {
+        for(int k0 = 0; k0 < n; k0 += TMM_DECOMPOSITION_BLOCK){
+            const int k1 = n - k0 < TMM_DECOMPOSITION_BLOCK ? n : k0 + TMM_DECOMPOSITION_BLOCK;
+
+            // Factor the panel (columns k0..k1), swapping whole rows
+            for(int k = k0; k < k1; k++){
+                int p = k;
+                Scalar best = A.data[k][k] < 0 ? -A.data[k][k] : A.data[k][k];
+                for(int i = k+1; i < n; i++){
+                    const Scalar v = A.data[i][k] < 0 ? -A.data[i][k] : A.data[i][k];
+                    if(v > best){ best = v; p = i; }
+                }
+                pivots[k] = (Size)p;
+                if(best == 0) return false;
+                if(p != k){
+                    for(int j = 0; j < n; j++){
+                        const Scalar t = A.data[k][j];
+                        A.data[k][j] = A.data[p][j];
+                        A.data[p][j] = t;
+                    }
+                }
+                for(int i = k+1; i < n; i++){
+                    const Scalar l = A.data[i][k] /= A.data[k][k];
+                    for(int j = k+1; j < k1; j++) A.data[i][j] -= l * A.data[k][j];
+                }
+            }
+
+            if(k1 == n) break;
+
+            // Rows k0..k1 right of the panel: solve L11 * U12 = A12
+            for(int k = k0; k < k1; k++)
+            for(int i = k+1; i < k1; i++){
+                const Scalar l = A.data[i][k];
+                for(int j = k1; j < n; j++) A.data[i][j] -= l * A.data[k][j];
+            }
+
+            // Trailing matrix: A22 -= L21 * U12
+            tmm::gemmSized<n,Scalar>(n-k1, n-k1, k1-k0, Scalar(-1),
+                &A.data[k1][k0], n, 1,
+                &A.data[k0][k1], n, 1,
+                &A.data[k1][k1], n, useThreadedFactorization(n));
+        }
+        return true;
+    } // end luDecompose
+
+
+    /// @brief Solves A*X = B in place, given the output of luDecompose()
+    /// @param LU the factored matrix
+    /// @param pivots the row swaps from luDecompose()
+    /// @param B the right-hand side, overwritten with the solution X
+    template<Size n, Size q, typename Scalar>
+    void
+    luSolve(const Matrix<n,n,Scalar> &LU, const Size pivots[n], Matrix<n,q,Scalar> &B)
+    {
+        for(Size i = 0; i < n; i++){
+            if(pivots[i] == i) continue;
+            for(Size j = 0; j < q; j++){
+                const Scalar t = B.data[i][j];
+                B.data[i][j] = B.data[pivots[i]][j];
+                B.data[pivots[i]][j] = t;
+            }
+        }
+        // Forward substitution with the unit lower-triangular L
+        for(Size i = 0; i < n; i++)
+        for(Size k = 0; k < i; k++)
+        for(Size j = 0; j < q; j++)
+        B.data[i][j] -= LU.data[i][k] * B.data[k][j];
+        // Back substitution with U
+        for(int i = n-1; i >= 0; i--){
+            for(Size k = i+1; k < n; k++)
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] -= LU.data[i][k] * B.data[k][j];
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] /= LU.data[i][i];
+        }
+    } // end luSolve
+
+
+    /// @brief Factors a symmetric positive-definite matrix in place as A = L*L^T
+    /// @param A the matrix to factor. Only its lower triangle is read.
+    /// On return, it holds L, with zeros above the diagonal.
+    /// @return false if the matrix is not positive-definite, in which case A is only partially factored
+    template<Size n, typename Scalar>
+    bool
+    choleskyDecompose(Matrix<n,n,Scalar> &A)
+    {
+        for(int k0 = 0; k0 < n; k0 += TMM_DECOMPOSITION_BLOCK){
+            const int k1 = n - k0 < TMM_DECOMPOSITION_BLOCK ? n : k0 + TMM_DECOMPOSITION_BLOCK;
+
+            // Factor the diagonal block and the panel below it, column by column
+            for(int k = k0; k < k1; k++){
+                Scalar d = A.data[k][k];
+                for(int p = k0; p < k; p++) d -= A.data[k][p] * A.data[k][p];
+                if(!(d > 0)) return false;
+                d = sqrt(d);
+                A.data[k][k] = d;
+                for(int i = k+1; i < n; i++){
+                    Scalar s = A.data[i][k];
+                    for(int p = k0; p < k; p++) s -= A.data[i][p] * A.data[k][p];
+                    A.data[i][k] = s / d;
+                }
+            }
+
+            if(k1 == n) break;
+
+            // Trailing matrix: A22 -= L21 * L21^T, reading L21 with swapped strides as its transpose.
+            // Only the lower triangle is used, so each strip of rows stops at the end of its diagonal block.
+            const int t = n - k1;
+            const int height = 4 * GemmBlocking<Scalar>::MR;
+            const int strips = (t + height - 1) / height;
+            auto strip = [&](int s){
+                const int r0 = s * height;
+                const int r1 = t - r0 < height ? t : r0 + height;
+                tmm::gemmSized<n,Scalar>(r1-r0, r1, k1-k0, Scalar(-1),
+                    &A.data[k1+r0][k0], n, 1,
+                    &A.data[k1][k0], 1, n,
+                    &A.data[k1+r0][k1], n, false);
+            };
+            #ifdef TMM_ENABLE_THREADS
+            // The longest strips are at the bottom, so hand them out first
+            if(useThreadedFactorization(n)) ThreadPool::shared().parallelFor(strips, [&](int s){ strip(strips-1 - s); });
+            else
+            #endif
+            for(int s = 0; s < strips; s++) strip(s);
+        }
+
+        for(Size i = 0; i < n; i++)
+        for(Size j = i+1; j < n; j++)
+        A.data[i][j] = 0;
+        return true;
+    } // end choleskyDecompose
+
+
+    /// @brief Solves A*X = B in place, given the lower-triangular factor from choleskyDecompose()
+    /// @param L the Cholesky factor of A
+    /// @param B the right-hand side, overwritten with the solution X
+    template<Size n, Size q, typename Scalar>
+    void
+    choleskySolve(const Matrix<n,n,Scalar> &L, Matrix<n,q,Scalar> &B)
+    {
+        // L * Y = B
+        for(Size i = 0; i < n; i++){
+            for(Size k = 0; k < i; k++)
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] -= L.data[i][k] * B.data[k][j];
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] /= L.data[i][i];
+        }
+        // L^T * X = Y
+        for(int i = n-1; i >= 0; i--){
+            for(Size k = i+1; k < n; k++)
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] -= L.data[k][i] * B.data[k][j];
+            for(Size j = 0; j < q; j++)
+            B.data[i][j] /= L.data[i][i];
+        }
+    } // end choleskySolve
+
+
+    /// @brief Updates a Cholesky factor in place so that L*L^T becomes L*L^T + x*x^T
+    /// @param L the lower-triangular factor from choleskyDecompose()
+    /// @param x the rank-1 term, as a column vector
+    /// @note This runs in O(n^2) with a sequence of Givens rotations and no temporary matrices.
+    template<Size n, typename Scalar>
+    void
+    choleskyUpdate(Matrix<n,n,Scalar> &L, Matrix<n,1,Scalar> x)
+    {
+        for(Size k = 0; k < n; k++){
+            const Scalar r = sqrt(L.data[k][k]*L.data[k][k] + x.data[k][0]*x.data[k][0]);
+            const Scalar c = r / L.data[k][k];
+            const Scalar s = x.data[k][0] / L.data[k][k];
+            L.data[k][k] = r;
+            for(Size i = k+1; i < n; i++){
+                L.data[i][k] = (L.data[i][k] + s * x.data[i][0]) / c;
+                x.data[i][0] = c * x.data[i][0] - s * L.data[i][k];
+            }
+        }
+    } // end choleskyUpdate
+
+
+    /// @brief Downdates a Cholesky factor in place so that L*L^T becomes L*L^T - x*x^T
+    /// @param L the lower-triangular factor from choleskyDecompose()
+    /// @param x the rank-1 term, as a column vector
+    /// @return false if L*L^T - x*x^T would not be positive-definite, in which case L is unchanged
+    /// @note This follows LINPACK's dchdd: it solves L*p = x to check that |p| < 1
+    /// before changing anything, then applies the rotations that zero p. It runs in O(n^2).
+    template<Size n, typename Scalar>
+    bool
+    choleskyDowndate(Matrix<n,n,Scalar> &L, Matrix<n,1,Scalar> x)
+    {
+        // x becomes p = L^-1 x
+        Scalar norm = 0;
+        for(Size i = 0; i < n; i++){
+            Scalar s = x.data[i][0];
+            for(Size k = 0; k < i; k++) s -= L.data[i][k] * x.data[k][0];
+            x.data[i][0] = s / L.data[i][i];
+            norm += x.data[i][0] * x.data[i][0];
+        }
+        if(!(norm < 1)) return false;
+
+        // Rotations that zero p from the bottom up; p is overwritten with their sines
+        Scalar cosines[n];
+        Scalar alpha = sqrt(1 - norm);
+        for(int i = n-1; i >= 0; i--){
+            const Scalar scale = alpha + (x.data[i][0] < 0 ? -x.data[i][0] : x.data[i][0]);
+            const Scalar a = alpha / scale;
+            const Scalar b = x.data[i][0] / scale;
+            const Scalar h = sqrt(a*a + b*b);
+            cosines[i]   = a / h;
+            x.data[i][0] = b / h;
+            alpha = scale * h;
+        }
+
+        // Apply the rotations to each row of L (each column of L^T)
+        for(Size j = 0; j < n; j++){
+            Scalar carry = 0;
+            for(int i = j; i >= 0; i--){
+                const Scalar t = cosines[i] * carry + x.data[i][0] * L.data[j][i];
+                L.data[j][i] = cosines[i] * L.data[j][i] - x.data[i][0] * carry;
+                carry = t;
+            }
+        }
+        return true;
+    } // end choleskyDowndate
+
+}
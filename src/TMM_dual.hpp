@@ -0,0 +1,285 @@
+// Forward-mode automatic differentiation with dual numbers.
+//
+// A Dual<Scalar,N> carries a value and its derivatives with respect to N
+// inputs. Matrix code that is written for any Scalar (including every
+// operation and decomposition in this library) computes exact derivatives
+// when it runs on Matrix<n,m,Dual<Scalar,N>>. Evaluating a model once on
+// dual numbers gives its full Jacobian, where finite differences need 2N
+// evaluations and still only give an approximation:
+//
+//     template<typename S> tmm::Matrix<3,1,S> model(const tmm::Matrix<6,1,S> &x);
+//     tmm::Matrix<3,6> J = tmm::jacobian(model<tmm::Dual<float,6>>, x);
+//
+// The derivatives are a fixed-size array updated in plain loops over N, which
+// the compiler unrolls and vectorizes. Comparisons only look at the value, so
+// pivoting and branches take the same path as they would on plain numbers.
+
+#pragma once
+
+#include <math.h>
+#include "TMM_matrix.hpp"
+
+
+namespace tmm{
+
+
+    template<typename Scalar, Size N>
+    struct Dual{
+        Scalar value;
+        Scalar derivatives[N];  // d value / d input i
+
+        Dual() : value(0) {
+            for(Size i = 0; i < N; i++) derivatives[i] = 0;
+        }
+
+        /// @brief A constant, with zero derivatives
+        Dual(Scalar value) : value(value) {
+            for(Size i = 0; i < N; i++) derivatives[i] = 0;
+        }
+
+        /// @brief Input number index, whose derivative with respect to itself is one
+        static Dual
+        variable(Scalar value, Size index)
+        {
+            Dual x(value);
+            x.derivatives[index] = 1;
+            return x;
+        }
+
+        /// @brief The value without its derivatives, as in (double)x
+        template<typename T>
+        explicit operator T() const { return T(value); }
+
+
+        Dual&
+        operator +=(const Dual &b)
+        {
+            value += b.value;
+            for(Size i = 0; i < N; i++) derivatives[i] += b.derivatives[i];
+            return *this;
+        }
+
+        Dual&
+        operator -=(const Dual &b)
+        {
+            value -= b.value;
+            for(Size i = 0; i < N; i++) derivatives[i] -= b.derivatives[i];
+            return *this;
+        }
+
+        Dual&
+        operator *=(const Dual &b)
+        {
+            for(Size i = 0; i < N; i++) derivatives[i] = derivatives[i] * b.value + value * b.derivatives[i];
+            value *= b.value;
+            return *this;
+        }
+
+        Dual&
+        operator /=(const Dual &b)
+        {
+            const Scalar r = 1 / b.value;
+            value *= r;
+            for(Size i = 0; i < N; i++) derivatives[i] = (derivatives[i] - value * b.derivatives[i]) * r;
+            return *this;
+        }
+
+        Dual& operator +=(Scalar b){ value += b; return *this; }
+        Dual& operator -=(Scalar b){ value -= b; return *this; }
+
+        Dual&
+        operator *=(Scalar b)
+        {
+            value *= b;
+            for(Size i = 0; i < N; i++) derivatives[i] *= b;
+            return *this;
+        }
+
+        Dual& operator /=(Scalar b){ return *this *= 1 / b; }
+
+
+        // Arithmetic. The overloads that take a plain Scalar skip the work on its zero derivatives.
+        // These are only found through argument-dependent lookup, so they never hide the
+        // overloads for built-in types.
+
+        friend Dual operator +(const Dual &a){ return a; }
+
+        friend Dual
+        operator -(const Dual &a)
+        {
+            Dual r;
+            r.value = -a.value;
+            for(Size i = 0; i < N; i++) r.derivatives[i] = -a.derivatives[i];
+            return r;
+        }
+
+        friend Dual operator +(Dual a, const Dual &b){ return a += b; }
+        friend Dual operator -(Dual a, const Dual &b){ return a -= b; }
+        friend Dual operator *(Dual a, const Dual &b){ return a *= b; }
+        friend Dual operator /(Dual a, const Dual &b){ return a /= b; }
+
+        friend Dual operator +(Dual a, Scalar b){ return a += b; }
+        friend Dual operator -(Dual a, Scalar b){ return a -= b; }
+        friend Dual operator *(Dual a, Scalar b){ return a *= b; }
+        friend Dual operator /(Dual a, Scalar b){ return a /= b; }
+
+        friend Dual operator +(Scalar a, Dual b){ return b += a; }
+        friend Dual operator -(Scalar a, const Dual &b){ return -b + a; }
+        friend Dual operator *(Scalar a, Dual b){ return b *= a; }
+
+        friend Dual
+        operator /(Scalar a, const Dual &b)
+        {
+            // d(a/b) = -a/b^2 db
+            Dual r;
+            r.value = a / b.value;
+            const Scalar s = -r.value / b.value;
+            for(Size i = 0; i < N; i++) r.derivatives[i] = s * b.derivatives[i];
+            return r;
+        }
+
+
+        // Comparisons look at the value only
+
+        friend bool operator ==(const Dual &a, const Dual &b){ return a.value == b.value; }
+        friend bool operator !=(const Dual &a, const Dual &b){ return a.value != b.value; }
+        friend bool operator < (const Dual &a, const Dual &b){ return a.value <  b.value; }
+        friend bool operator > (const Dual &a, const Dual &b){ return a.value >  b.value; }
+        friend bool operator <=(const Dual &a, const Dual &b){ return a.value <= b.value; }
+        friend bool operator >=(const Dual &a, const Dual &b){ return a.value >= b.value; }
+
+        friend bool operator ==(const Dual &a, Scalar b){ return a.value == b; }
+        friend bool operator !=(const Dual &a, Scalar b){ return a.value != b; }
+        friend bool operator < (const Dual &a, Scalar b){ return a.value <  b; }
+        friend bool operator > (const Dual &a, Scalar b){ return a.value >  b; }
+        friend bool operator <=(const Dual &a, Scalar b){ return a.value <= b; }
+        friend bool operator >=(const Dual &a, Scalar b){ return a.value >= b; }
+
+        friend bool operator ==(Scalar a, const Dual &b){ return a == b.value; }
+        friend bool operator !=(Scalar a, const Dual &b){ return a != b.value; }
+        friend bool operator < (Scalar a, const Dual &b){ return a <  b.value; }
+        friend bool operator > (Scalar a, const Dual &b){ return a >  b.value; }
+        friend bool operator <=(Scalar a, const Dual &b){ return a <= b.value; }
+        friend bool operator >=(Scalar a, const Dual &b){ return a >= b.value; }
+
+
+        // Elementary functions, applying the chain rule: f(a + da) = f(a) + f'(a) da
+
+        friend Dual
+        sqrt(const Dual &a)
+        {
+            const Scalar s = sqrt(a.value);
+            return compose(a, s, 1 / (2 * s));
+        }
+
+        friend Dual
+        exp(const Dual &a)
+        {
+            const Scalar e = exp(a.value);
+            return compose(a, e, e);
+        }
+
+        friend Dual log(const Dual &a){ return compose(a, log(a.value), 1 / a.value); }
+        friend Dual sin(const Dual &a){ return compose(a, sin(a.value), cos(a.value)); }
+        friend Dual cos(const Dual &a){ return compose(a, cos(a.value), -sin(a.value)); }
+
+        friend Dual
+        tan(const Dual &a)
+        {
+            const Scalar t = tan(a.value);
+            return compose(a, t, 1 + t*t);
+        }
+
+        friend Dual asin(const Dual &a){ return compose(a, asin(a.value), 1 / sqrt(1 - a.value*a.value)); }
+        friend Dual acos(const Dual &a){ return compose(a, acos(a.value), -1 / sqrt(1 - a.value*a.value)); }
+        friend Dual atan(const Dual &a){ return compose(a, atan(a.value), 1 / (1 + a.value*a.value)); }
+        friend Dual fabs(const Dual &a){ return a.value < 0 ? -a : a; }
+        friend Dual abs(const Dual &a){ return a.value < 0 ? -a : a; }
+
+        friend Dual
+        atan2(const Dual &y, const Dual &x)
+        {
+            // d atan2(y,x) = (x dy - y dx) / (x^2 + y^2)
+            Dual r;
+            r.value = atan2(y.value, x.value);
+            const Scalar s = 1 / (x.value*x.value + y.value*y.value);
+            for(Size i = 0; i < N; i++) r.derivatives[i] = (x.value * y.derivatives[i] - y.value * x.derivatives[i]) * s;
+            return r;
+        }
+
+        friend Dual
+        pow(const Dual &a, Scalar p)
+        {
+            const Scalar f = pow(a.value, p);
+            return compose(a, f, p * pow(a.value, p - 1));
+        }
+
+        private:
+
+        // f(a), given f(a.value) and f'(a.value)
+        static Dual
+        compose(const Dual &a, Scalar f, Scalar df)
+        {
+            Dual r;
+            r.value = f;
+            for(Size i = 0; i < N; i++) r.derivatives[i] = df * a.derivatives[i];
+            return r;
+        }
+    }; // end Dual struct
+
+
+
+    /// @brief Turns a point into N dual numbers, where element i varies with input i
+    template<Size N, typename Scalar>
+    Matrix<N,1,Dual<Scalar,N>>
+    dualVariables(const Matrix<N,1,Scalar> &x)
+    {
+        Matrix<N,1,Dual<Scalar,N>> result;
+        for(Size i = 0; i < N; i++) result.data[i][0] = Dual<Scalar,N>::variable(x.data[i][0], i);
+        return result;
+    }
+
+
+    /// @brief The values of a matrix of dual numbers, without their derivatives
+    template<Size n, Size m, typename Scalar, Size N>
+    Matrix<n,m,Scalar>
+    dualValues(const Matrix<n,m,Dual<Scalar,N>> &y)
+    {
+        Matrix<n,m,Scalar> result;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < m; j++)
+        result.data[i][j] = y.data[i][j].value;
+        return result;
+    }
+
+
+    /// @brief The Jacobian of a column vector of dual numbers: element (i,j) is d y_i / d input j
+    template<Size n, typename Scalar, Size N>
+    Matrix<n,N,Scalar>
+    jacobian(const Matrix<n,1,Dual<Scalar,N>> &y)
+    {
+        Matrix<n,N,Scalar> J;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < N; j++)
+        J.data[i][j] = y.data[i][0].derivatives[j];
+        return J;
+    }
+
+
+    /// @brief Evaluates f once on dual numbers to find its Jacobian at x
+    /// @param f a function that takes a Matrix<N,1,Dual<Scalar,N>> and returns a Matrix<n,1,Dual<Scalar,N>>,
+    /// such as a function template written for any Scalar
+    /// @param x the point to differentiate at
+    /// @param y if not null, set to f(x)
+    /// @return the n x N Jacobian of f at x
+    template<typename F, Size N, typename Scalar>
+    auto
+    jacobian(F f, const Matrix<N,1,Scalar> &x, decltype(dualValues(f(dualVariables(x)))) *y = nullptr)
+        -> decltype(jacobian(f(dualVariables(x))))
+    {
+        const auto fx = f(dualVariables(x));
+        if(y) *y = dualValues(fx);
+        return jacobian(fx);
+    }
+
+}
@@ -0,0 +1,202 @@
+// The matrix exponential, for discretizing continuous-time models on the device.
+//
+// expm() uses scaling and squaring with a diagonal Pade approximant
+// (Higham, "The Scaling and Squaring Method for the Matrix Exponential
+// Revisited", 2005). The lowest Pade order that is accurate for the
+// 1-norm of the matrix is used, so small matrices times small time steps
+// take only a few products and one LU solve.
+
+#pragma once
+
+#include <math.h>
+#include "TMM_matrix.hpp"
+#include "TMM_decompositions.hpp"
+#include "TMM_dual.hpp"
+#include "TMM_reductions.hpp"
+
+
+namespace tmm{
+
+
+    /// @brief The Pade orders used by expm() and the largest 1-norm each one is accurate for
+    /// @tparam Scalar the element type. Single precision needs lower orders than double precision.
+    template<typename Scalar>
+    struct ExpmParameters{
+        static const int count = 5;
+        static int order(int i){
+            static const int orders[count] = {3, 5, 7, 9, 13};
+            return orders[i];
+        }
+        static double theta(int i){
+            static const double thetas[count] = {
+                1.495585217958292e-2, 2.539398330063230e-1, 9.504178996162932e-1,
+                2.097847961257068e0,  5.371920351148152e0
+            };
+            return thetas[i];
+        }
+    };
+
+    template<>
+    struct ExpmParameters<float>{
+        static const int count = 3;
+        static int order(int i){
+            static const int orders[count] = {3, 5, 7};
+            return orders[i];
+        }
+        static double theta(int i){
+            static const double thetas[count] = {
+                4.258730016922831e-1, 1.880152677804762e0, 3.925724783138660e0
+            };
+            return thetas[i];
+        }
+    };
+
+    // Dual numbers follow the precision of their values
+    template<typename Scalar, Size N>
+    struct ExpmParameters<Dual<Scalar,N>> : ExpmParameters<Scalar>{};
+
+
+    /// @brief Returns the coefficients b_0..b_m of the degree-m Pade approximant to exp
+    inline const double*
+    expmPadeCoefficients(int m)
+    {
+        static const double b3[]  = {120., 60., 12., 1.};
+        static const double b5[]  = {30240., 15120., 3360., 420., 30., 1.};
+        static const double b7[]  = {17297280., 8648640., 1995840., 277200., 25200., 1512., 56., 1.};
+        static const double b9[]  = {17643225600., 8821612800., 2075673600., 302702400., 30270240.,
+                                     2162160., 110880., 3960., 90., 1.};
+        static const double b13[] = {64764752532480000., 32382376266240000., 7771770303897600.,
+                                     1187353796428800., 129060195264000., 10559470521600.,
+                                     670442572800., 33522128640., 1323241920., 40840800.,
+                                     960960., 16380., 182., 1.};
+        switch(m){
+            case 3:  return b3;
+            case 5:  return b5;
+            case 7:  return b7;
+            case 9:  return b9;
+            default: return b13;
+        }
+    }
+
+
+    /// @brief Evaluates the odd (U) and even (V) parts of the degree-m Pade approximant at A
+    /// @note Orders up to 9 take (m+1)/2 products. Order 13 takes 6, by factoring out A^6.
+    template<Size n, typename Scalar>
+    void
+    expmPade(const Matrix<n,n,Scalar> &A, int m, Matrix<n,n,Scalar> &U, Matrix<n,n,Scalar> &V)
+    {
+        const double *b = expmPadeCoefficients(m);
+        const Matrix<n,n,Scalar> A2 = A * A;
+        Matrix<n,n,Scalar> inner; // U = A * inner
+
+        if(m == 13){
+            const Matrix<n,n,Scalar> A4 = A2 * A2;
+            const Matrix<n,n,Scalar> A6 = A4 * A2;
+            Matrix<n,n,Scalar> high_U, high_V;
+            for(Size i = 0; i < n; i++)
+            for(Size j = 0; j < n; j++){
+                const Scalar id = i == j ? Scalar(1) : Scalar(0);
+                high_U.data[i][j] = Scalar(b[13])*A6.data[i][j] + Scalar(b[11])*A4.data[i][j] + Scalar(b[9])*A2.data[i][j];
+                high_V.data[i][j] = Scalar(b[12])*A6.data[i][j] + Scalar(b[10])*A4.data[i][j] + Scalar(b[8])*A2.data[i][j];
+                inner.data[i][j]  = Scalar(b[7])*A6.data[i][j] + Scalar(b[5])*A4.data[i][j] + Scalar(b[3])*A2.data[i][j] + Scalar(b[1])*id;
+                V.data[i][j]      = Scalar(b[6])*A6.data[i][j] + Scalar(b[4])*A4.data[i][j] + Scalar(b[2])*A2.data[i][j] + Scalar(b[0])*id;
+            }
+            A6.multiplyAccumulate(high_U, inner);
+            A6.multiplyAccumulate(high_V, V);
+        }
+        else{
+            V = Scalar(0);
+            inner = Scalar(0);
+            for(Size i = 0; i < n; i++){
+                V.data[i][i]     = Scalar(b[0]);
+                inner.data[i][i] = Scalar(b[1]);
+            }
+            Matrix<n,n,Scalar> power = A2;
+            for(int k = 2; ; k += 2){
+                for(Size i = 0; i < n; i++)
+                for(Size j = 0; j < n; j++){
+                    V.data[i][j]     += Scalar(b[k])   * power.data[i][j];
+                    inner.data[i][j] += Scalar(b[k+1]) * power.data[i][j];
+                }
+                if(k + 2 > m) break;
+                power = power * A2;
+            }
+        }
+
+        U = A * inner;
+    } // end expmPade
+
+
+    /// @brief Computes the matrix exponential e^A
+    /// @param A a square matrix
+    /// @return e^A, accurate to about the precision of Scalar
+    template<Size n, typename Scalar>
+    Matrix<n,n,Scalar>
+    expm(const Matrix<n,n,Scalar> &A)
+    {
+        typedef ExpmParameters<Scalar> Params;
+        const double norm = (double)oneNorm(A);
+
+        // Use the lowest order that is accurate without scaling, or scale A down for the highest order
+        int order = Params::order(Params::count - 1);
+        int squarings = 0;
+        for(int i = 0; i < Params::count; i++){
+            if(norm <= Params::theta(i)){
+                order = Params::order(i);
+                break;
+            }
+        }
+        if(norm > Params::theta(Params::count - 1)){
+            squarings = (int)ceil(log(norm / Params::theta(Params::count - 1)) / log(2.0));
+        }
+        const Matrix<n,n,Scalar> scaled = A * Scalar(ldexp(1.0, -squarings));
+
+        // r = (V - U)^-1 (V + U)
+        Matrix<n,n,Scalar> U, V;
+        expmPade(scaled, order, U, V);
+        Matrix<n,n,Scalar> R = V + U;
+        Matrix<n,n,Scalar> Q = V - U;
+        Size pivots[n];
+        luDecompose(Q, pivots); // V - U is well-conditioned for these orders and norms
+        luSolve(Q, pivots, R);
+
+        for(int s = 0; s < squarings; s++) R = R * R;
+        return R;
+    } // end expm
+
+
+    /// @brief Discretizes x' = A x + w, where w is white noise with covariance Qc, with Van Loan's method
+    /// @param A the continuous-time state matrix
+    /// @param Qc the continuous-time process noise covariance
+    /// @param dt the time step
+    /// @param Phi on return, the discrete-time state transition matrix e^(A dt)
+    /// @param Qd on return, the discrete-time process noise covariance
+    /// @note This takes one exponential of the 2n x 2n block matrix [-A Qc; 0 A^T] dt,
+    /// so n must be at most 127.
+    template<Size n, typename Scalar>
+    void
+    vanLoanDiscretize(const Matrix<n,n,Scalar> &A, const Matrix<n,n,Scalar> &Qc, Scalar dt,
+                      Matrix<n,n,Scalar> &Phi, Matrix<n,n,Scalar> &Qd)
+    {
+        static_assert(n <= 127, "vanLoanDiscretize builds a 2n x 2n matrix, so n must be at most 127");
+        Matrix<2*n,2*n,Scalar> M;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++){
+            M.data[i][j]     = -A.data[i][j] * dt;
+            M.data[i][j+n]   =  Qc.data[i][j] * dt;
+            M.data[i+n][j+n] =  A.data[j][i] * dt;
+        }
+        const Matrix<2*n,2*n,Scalar> E = expm(M);
+
+        // Phi = E22^T and Qd = Phi * E12
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++)
+        Phi.data[i][j] = E.data[j+n][i+n];
+        Qd = Scalar(0);
+        for(Size i = 0; i < n; i++)
+        for(Size k = 0; k < n; k++)
+        for(Size j = 0; j < n; j++)
+        Qd.data[i][j] += Phi.data[i][k] * E.data[k][j+n];
+    } // end vanLoanDiscretize
+
+}
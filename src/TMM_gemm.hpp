@@ -0,0 +1,428 @@
+// A cache-blocked, packed matrix-matrix product for large matrices.
+//
+// The naive i-j-k loop in Matrix::operator* is the best choice for the small
+// matrices this library is designed for, but for matrices with 64 or more
+// rows and columns it streams the right-hand operand through the cache once
+// per row of the result. This kernel follows the usual Goto/BLIS structure:
+//   - the right-hand operand is packed into KC x NC panels that stay in L2,
+//   - the left-hand operand is packed into MC x KC blocks that stay in L1/L2,
+//   - an MR x NR micro-kernel keeps a tile of the result in registers.
+//
+// On x86 the micro-kernel holds its tile in SSE or AVX registers (with FMA
+// when the compiler targets it): 6x8 floats or 6x4 doubles with the default
+// SSE2 flags, and 6x16 floats or 6x8 doubles with -mavx. Elsewhere, and with
+// TMM_DISABLE_SIMD, it is a plain loop over a 4x8 tile of floats or a 4x4 tile
+// of wider types (see GemmBlocking).
+
+#pragma once
+
+#include "TMM_enable_if.hpp"
+#include "TMM_thread_pool.hpp"
+
+#ifndef TMM_DISABLE_SIMD
+    #if defined(__AVX__)
+        #include <immintrin.h>
+        #define TMM_GEMM_AVX
+    #elif defined(__SSE2__) || defined(_M_X64)
+        #include <emmintrin.h>
+        #define TMM_GEMM_SSE
+    #endif
+#endif
+
+// Matrix products with every dimension at least this large use the blocked kernel.
+// Define TMM_DISABLE_BLOCKED_GEMM to always use the naive loop.
+#ifdef TMM_DISABLE_BLOCKED_GEMM
+    #undef  TMM_GEMM_THRESHOLD
+    #define TMM_GEMM_THRESHOLD 256 // larger than any matrix dimension
+#endif
+#ifndef TMM_GEMM_THRESHOLD
+    #define TMM_GEMM_THRESHOLD 64
+#endif
+
+
+namespace tmm{
+
+    /// @brief Returns true if the product of an n x m matrix and an m x q matrix should use the blocked kernel
+    constexpr bool useBlockedProduct(unsigned int n, unsigned int m, unsigned int q){
+        return n >= TMM_GEMM_THRESHOLD && m >= TMM_GEMM_THRESHOLD && q >= TMM_GEMM_THRESHOLD;
+    }
+
+
+    /// @brief A SIMD register of Scalars for the micro-kernel. A width of 1 means there is none.
+    template<typename Scalar>
+    struct GemmVector{
+        static const int width = 1;
+    };
+
+    #if defined(TMM_GEMM_AVX)
+    template<>
+    struct GemmVector<float>{
+        typedef __m256 Type;
+        static const int width = 8;
+        static Type zero(){ return _mm256_setzero_ps(); }
+        static Type load(const float *p){ return _mm256_loadu_ps(p); }
+        static void store(float *p, Type v){ _mm256_storeu_ps(p, v); }
+        static Type broadcast(float x){ return _mm256_set1_ps(x); }
+        #ifdef __FMA__
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm256_fmadd_ps(a, b, c); }
+        #else
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+        #endif
+    };
+
+    template<>
+    struct GemmVector<double>{
+        typedef __m256d Type;
+        static const int width = 4;
+        static Type zero(){ return _mm256_setzero_pd(); }
+        static Type load(const double *p){ return _mm256_loadu_pd(p); }
+        static void store(double *p, Type v){ _mm256_storeu_pd(p, v); }
+        static Type broadcast(double x){ return _mm256_set1_pd(x); }
+        #ifdef __FMA__
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm256_fmadd_pd(a, b, c); }
+        #else
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+        #endif
+    };
+    #elif defined(TMM_GEMM_SSE)
+    template<>
+    struct GemmVector<float>{
+        typedef __m128 Type;
+        static const int width = 4;
+        static Type zero(){ return _mm_setzero_ps(); }
+        static Type load(const float *p){ return _mm_loadu_ps(p); }
+        static void store(float *p, Type v){ _mm_storeu_ps(p, v); }
+        static Type broadcast(float x){ return _mm_set1_ps(x); }
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    };
+
+    template<>
+    struct GemmVector<double>{
+        typedef __m128d Type;
+        static const int width = 2;
+        static Type zero(){ return _mm_setzero_pd(); }
+        static Type load(const double *p){ return _mm_loadu_pd(p); }
+        static void store(double *p, Type v){ _mm_storeu_pd(p, v); }
+        static Type broadcast(double x){ return _mm_set1_pd(x); }
+        static Type multiplyAdd(Type a, Type b, Type c){ return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    };
+    #endif
+
+
+    /// @brief The depth of the packed blocks for elements of the given size. The blocks take
+    /// at most about 96 KB of stack, so larger element types (double, Dual) get shallower blocks.
+    constexpr int gemmBlockDepth(unsigned long bytes){
+        return 512 / bytes > 128 ? 128 : 512 / bytes < 8 ? 8 : (int)(512 / bytes);
+    }
+
+
+    /// @brief Blocking parameters for the packed matrix-matrix product
+    /// @tparam Scalar the element type
+    /// @note MC must be a multiple of MR, and NC must be a multiple of NR.
+    /// With SIMD, the register tile is two vectors wide and 6 rows tall, which keeps 12 of the
+    /// 16 vector registers for the tile and leaves the rest for the operands.
+    template<typename Scalar>
+    struct GemmBlocking{
+        static const int MR = GemmVector<Scalar>::width > 1 ? 6 : 4;                        // rows in the register tile
+        static const int NR = GemmVector<Scalar>::width > 1 ? 2 * GemmVector<Scalar>::width
+                                                            : (sizeof(Scalar) > 4 ? 4 : 8); // columns in the register tile
+        static const int MC = MR == 6 ? 72 : 64;                  // rows of the packed left-hand block
+        static const int KC = gemmBlockDepth(sizeof(Scalar));   // depth of both packed blocks
+        static const int NC = 128;                                // columns of the packed right-hand panel
+    };
+
+
+    /// @brief Packs an mc x kc block of A into MR-row slivers, zero-padding the last sliver
+    /// @param A the first element of the block
+    /// @param rs the distance between rows of A
+    /// @param cs the distance between columns of A
+    template<typename Scalar, int MR>
+    void
+    gemmPackA(int mc, int kc, const Scalar *A, int rs, int cs, Scalar *buffer)
+    {
+        for(int i = 0; i < mc; i += MR){
+            const int mr = mc - i < MR ? mc - i : MR;
+            for(int p = 0; p < kc; p++){
+                for(int r = 0; r < mr; r++) buffer[r] = A[(i+r)*rs + p*cs];
+                for(int r = mr; r < MR; r++) buffer[r] = 0;
+                buffer += MR;
+            }
+        }
+    }
+
+
+    /// @brief Packs a kc x nc panel of B into NR-column slivers, zero-padding the last sliver
+    /// @param B the first element of the panel
+    /// @param rs the distance between rows of B
+    /// @param cs the distance between columns of B
+    template<typename Scalar, int NR>
+    void
+    gemmPackB(int kc, int nc, const Scalar *B, int rs, int cs, Scalar *buffer)
+    {
+        for(int j = 0; j < nc; j += NR){
+            const int nr = nc - j < NR ? nc - j : NR;
+            for(int p = 0; p < kc; p++){
+                for(int c = 0; c < nr; c++) buffer[c] = B[p*rs + (j+c)*cs];
+                for(int c = nr; c < NR; c++) buffer[c] = 0;
+                buffer += NR;
+            }
+        }
+    }
+
+
+    /// @brief Computes C += alpha * a * b for one MR x NR tile of C from packed slivers
+    /// @param mr the number of valid rows in this tile (at most MR)
+    /// @param nr the number of valid columns in this tile (at most NR)
+    template<typename Scalar, int MR, int NR>
+    inline tmm::enable_if_t<GemmVector<Scalar>::width == 1>
+    gemmMicroKernel(int kc, Scalar alpha, const Scalar *a, const Scalar *b, Scalar *C, int ldc, int mr, int nr)
+    {
+        Scalar acc[MR][NR];
+        for(int i = 0; i < MR; i++)
+        for(int j = 0; j < NR; j++)
+        acc[i][j] = 0;
+
+        for(int p = 0; p < kc; p++){
+            for(int i = 0; i < MR; i++){
+                const Scalar ai = a[i];
+                for(int j = 0; j < NR; j++) acc[i][j] += ai * b[j];
+            }
+            a += MR;
+            b += NR;
+        }
+
+        for(int i = 0; i < mr; i++)
+        for(int j = 0; j < nr; j++)
+        C[i*ldc + j] += alpha * acc[i][j];
+    }
+
+
+    /// @brief The micro-kernel on SIMD registers: each row of the tile is NR/width vectors,
+    /// and each step broadcasts one element of a against a row of b
+    template<typename Scalar, int MR, int NR>
+    inline tmm::enable_if_t<(GemmVector<Scalar>::width > 1)>
+    gemmMicroKernel(int kc, Scalar alpha, const Scalar *a, const Scalar *b, Scalar *C, int ldc, int mr, int nr)
+    {
+        typedef GemmVector<Scalar> V;
+        typedef typename V::Type Vector;
+        static_assert(NR % V::width == 0, "the register tile must be a whole number of vectors wide");
+        const int NV = NR / V::width;
+
+        Vector acc[MR][NV];
+        for(int i = 0; i < MR; i++)
+        for(int v = 0; v < NV; v++)
+        acc[i][v] = V::zero();
+
+        for(int p = 0; p < kc; p++){
+            Vector bv[NV];
+            for(int v = 0; v < NV; v++) bv[v] = V::load(b + v*V::width);
+            for(int i = 0; i < MR; i++){
+                const Vector ai = V::broadcast(a[i]);
+                for(int v = 0; v < NV; v++) acc[i][v] = V::multiplyAdd(ai, bv[v], acc[i][v]);
+            }
+            a += MR;
+            b += NR;
+        }
+
+        if(mr == MR && nr == NR){
+            const Vector va = V::broadcast(alpha);
+            for(int i = 0; i < MR; i++)
+            for(int v = 0; v < NV; v++){
+                Scalar *c = C + i*ldc + v*V::width;
+                V::store(c, V::multiplyAdd(va, acc[i][v], V::load(c)));
+            }
+        }
+        else{
+            // An edge tile: only part of it lies inside C
+            Scalar tile[MR][NR];
+            for(int i = 0; i < MR; i++)
+            for(int v = 0; v < NV; v++)
+            V::store(&tile[i][v*V::width], acc[i][v]);
+            for(int i = 0; i < mr; i++)
+            for(int j = 0; j < nr; j++)
+            C[i*ldc + j] += alpha * tile[i][j];
+        }
+    }
+
+
+    /// @brief Computes C += alpha * A * B with a cache-blocked, packed kernel
+    /// @param M the number of rows in A and C
+    /// @param N the number of columns in B and C
+    /// @param K the number of columns in A and rows in B
+    /// @param A the first element of A, where A(i,k) = A[i*rsA + k*csA]
+    /// @param B the first element of B, where B(k,j) = B[k*rsB + j*csB]
+    /// @param C the first element of C, where C(i,j) = C[i*ldc + j]
+    /// @note Passing swapped strides reads an operand as its transpose without copying it.
+    /// @note This runs on the calling thread. Use gemm() to split large products across threads.
+    template<typename Scalar>
+    void
+    gemmSerial(int M, int N, int K, Scalar alpha,
+         const Scalar *A, int rsA, int csA,
+         const Scalar *B, int rsB, int csB,
+         Scalar *C, int ldc)
+    {
+        typedef GemmBlocking<Scalar> Blk;
+        alignas(64) Scalar packedA[Blk::MC * Blk::KC];
+        alignas(64) Scalar packedB[Blk::KC * Blk::NC];
+
+        for(int jc = 0; jc < N; jc += Blk::NC){
+            const int nc = N - jc < Blk::NC ? N - jc : Blk::NC;
+            for(int pc = 0; pc < K; pc += Blk::KC){
+                const int kc = K - pc < Blk::KC ? K - pc : Blk::KC;
+                gemmPackB<Scalar, Blk::NR>(kc, nc, B + pc*rsB + jc*csB, rsB, csB, packedB);
+
+                for(int ic = 0; ic < M; ic += Blk::MC){
+                    const int mc = M - ic < Blk::MC ? M - ic : Blk::MC;
+                    gemmPackA<Scalar, Blk::MR>(mc, kc, A + ic*rsA + pc*csA, rsA, csA, packedA);
+
+                    for(int jr = 0; jr < nc; jr += Blk::NR){
+                        const int nr = nc - jr < Blk::NR ? nc - jr : Blk::NR;
+                        for(int ir = 0; ir < mc; ir += Blk::MR){
+                            const int mr = mc - ir < Blk::MR ? mc - ir : Blk::MR;
+                            gemmMicroKernel<Scalar, Blk::MR, Blk::NR>(
+                                kc, alpha, packedA + ir*kc, packedB + jr*kc,
+                                C + (ic+ir)*ldc + jc + jr, ldc, mr, nr);
+                        }
+                    }
+                }
+            }
+        }
+    } // end gemmSerial
+
+
+
+    #ifdef TMM_ENABLE_THREADS
+    /// @brief Computes C += alpha * A * B by splitting C into 2D tiles and running each tile on the shared thread pool
+    /// @note Tiles are multiples of the register tile and start as large as the packing blocks,
+    /// shrinking until there are at least two tiles per thread.
+    template<typename Scalar>
+    void
+    gemmParallel(int M, int N, int K, Scalar alpha,
+                 const Scalar *A, int rsA, int csA,
+                 const Scalar *B, int rsB, int csB,
+                 Scalar *C, int ldc)
+    {
+        typedef GemmBlocking<Scalar> Blk;
+        const int wanted = 2 * (int)ThreadPool::shared().size();
+        int tm = Blk::MC, tn = Blk::NC;
+        for(;;){
+            const int tiles = ((M + tm - 1) / tm) * ((N + tn - 1) / tn);
+            if(tiles >= wanted) break;
+            if(tn >= tm && tn > 2*Blk::NR) tn /= 2;
+            else if(tm > 2*Blk::MR)         tm /= 2;
+            else break;
+        }
+
+        const int rowTiles = (M + tm - 1) / tm;
+        const int colTiles = (N + tn - 1) / tn;
+        ThreadPool::shared().parallelFor(rowTiles * colTiles, [&](int t){
+            const int i0 = (t / colTiles) * tm;
+            const int j0 = (t % colTiles) * tn;
+            const int mt = M - i0 < tm ? M - i0 : tm;
+            const int nt = N - j0 < tn ? N - j0 : tn;
+            gemmSerial<Scalar>(mt, nt, K, alpha,
+                A + i0*rsA, rsA, csA,
+                B + j0*csB, rsB, csB,
+                C + i0*ldc + j0, ldc);
+        });
+    } // end gemmParallel
+    #endif
+
+
+    /// @brief Computes C += alpha * A * B with a cache-blocked, packed kernel
+    /// @note See gemmSerial() for the meaning of each parameter.
+    /// @param threaded if true and TMM_ENABLE_THREADS is defined, the product is split across the shared thread pool
+    template<typename Scalar>
+    void
+    gemm(int M, int N, int K, Scalar alpha,
+         const Scalar *A, int rsA, int csA,
+         const Scalar *B, int rsB, int csB,
+         Scalar *C, int ldc, bool threaded)
+    {
+        #ifdef TMM_ENABLE_THREADS
+        if(threaded && ThreadPool::shared().size() > 1){
+            gemmParallel<Scalar>(M, N, K, alpha, A, rsA, csA, B, rsB, csB, C, ldc);
+            return;
+        }
+        #else
+        (void)threaded;
+        #endif
+        gemmSerial<Scalar>(M, N, K, alpha, A, rsA, csA, B, rsB, csB, C, ldc);
+    }
+
+
+    /// @brief Computes C += alpha * A * B with a cache-blocked, packed kernel
+    /// @note When TMM_ENABLE_THREADS is defined, products with at least
+    /// TMM_THREADS_THRESHOLD multiply-adds run on the shared thread pool.
+    template<typename Scalar>
+    void
+    gemm(int M, int N, int K, Scalar alpha,
+         const Scalar *A, int rsA, int csA,
+         const Scalar *B, int rsB, int csB,
+         Scalar *C, int ldc)
+    {
+        #ifdef TMM_ENABLE_THREADS
+        const bool threaded = (long)M * N * K >= (long)TMM_THREADS_THRESHOLD;
+        #else
+        const bool threaded = false;
+        #endif
+        gemm<Scalar>(M, N, K, alpha, A, rsA, csA, B, rsB, csB, C, ldc, threaded);
+    } // end gemm
+
+
+    /// @brief Returns true if the updates inside a factorization of an n x n matrix should run on the thread pool
+    /// @note Each update is only a panel deep, so it would rarely reach TMM_THREADS_THRESHOLD on its own.
+    /// Instead, the whole factorization is threaded when an n x n x n product would be.
+    #ifdef TMM_ENABLE_THREADS
+    constexpr bool useThreadedFactorization(unsigned int n){
+        return (long)n * n * n >= (long)TMM_THREADS_THRESHOLD;
+    }
+    #else
+    constexpr bool useThreadedFactorization(unsigned int){
+        return false;
+    }
+    #endif
+
+
+    /// @brief Computes C += alpha * A * B with a simple loop, using the same conventions as gemm()
+    template<typename Scalar>
+    void
+    gemmNaive(int M, int N, int K, Scalar alpha,
+              const Scalar *A, int rsA, int csA,
+              const Scalar *B, int rsB, int csB,
+              Scalar *C, int ldc)
+    {
+        for(int i = 0; i < M; i++)
+        for(int k = 0; k < K; k++){
+            const Scalar a = alpha * A[i*rsA + k*csA];
+            for(int j = 0; j < N; j++) C[i*ldc + j] += a * B[k*rsB + j*csB];
+        }
+    }
+
+
+    /// @brief Computes C += alpha * A * B on blocks of an n x n matrix, choosing the kernel at compile time
+    /// @tparam n the size of the matrix that owns the blocks
+    /// @param threaded whether the blocked kernel should split the product across the thread pool
+    /// @note Matrices too small for the blocked kernel never instantiate it, which keeps
+    /// its packing buffers off the stack of small devices.
+    template<unsigned int n, typename Scalar>
+    tmm::enable_if_t<!useBlockedProduct(n,n,n)>
+    gemmSized(int M, int N, int K, Scalar alpha,
+              const Scalar *A, int rsA, int csA,
+              const Scalar *B, int rsB, int csB,
+              Scalar *C, int ldc, bool)
+    {
+        gemmNaive<Scalar>(M, N, K, alpha, A, rsA, csA, B, rsB, csB, C, ldc);
+    }
+
+    template<unsigned int n, typename Scalar>
+    tmm::enable_if_t<useBlockedProduct(n,n,n)>
+    gemmSized(int M, int N, int K, Scalar alpha,
+              const Scalar *A, int rsA, int csA,
+              const Scalar *B, int rsB, int csB,
+              Scalar *C, int ldc, bool threaded)
+    {
+        gemm<Scalar>(M, N, K, alpha, A, rsA, csA, B, rsB, csB, C, ldc, threaded);
+    }
+
+}
@@ -0,0 +1,159 @@
+// Low-rank updates of a known inverse (Sherman-Morrison and Woodbury).
+//
+// When A changes by a low-rank term, its inverse can be updated in O(n^2 k)
+// instead of inverting A again. These updates lose accuracy when the updated
+// matrix is close to singular, so each one checks the conditioning of the
+// small "capacitance" system it solves and reports when the update is unsafe.
+
+#pragma once
+
+#include "TMM_matrix.hpp"
+#include "TMM_decompositions.hpp"
+
+#ifndef TMM_UPDATE_TOLERANCE
+    #define TMM_UPDATE_TOLERANCE 1e-4
+#endif
+
+
+namespace tmm{
+
+
+    /// @brief Updates Ainv = A^-1 to (A + u*v^T)^-1 in place with the Sherman-Morrison formula
+    /// @param Ainv the inverse of A, overwritten with the inverse of the updated matrix
+    /// @param u the column vector of the rank-1 term
+    /// @param v the row vector of the rank-1 term, as a column vector
+    /// @param tolerance the update is rejected if |1 + v^T Ainv u| <= tolerance * (1 + |v^T Ainv u|)
+    /// @return false if the update is unstable, in which case Ainv is unchanged
+    template<Size n, typename Scalar>
+    bool
+    rank1UpdateInverse(Matrix<n,n,Scalar> &Ainv, const Matrix<n,1,Scalar> &u, const Matrix<n,1,Scalar> &v,
+                       Scalar tolerance = Scalar(TMM_UPDATE_TOLERANCE))
+    {
+        // Ainv*u and v^T*Ainv
+        Scalar Au[n], vA[n];
+        for(Size i = 0; i < n; i++){
+            Au[i] = 0;
+            vA[i] = 0;
+        }
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++){
+            Au[i] += Ainv.data[i][j] * u.data[j][0];
+            vA[j] += v.data[i][0] * Ainv.data[i][j];
+        }
+
+        Scalar w = 0;
+        for(Size i = 0; i < n; i++) w += v.data[i][0] * Au[i];
+        const Scalar denominator = 1 + w;
+        const Scalar scale = 1 + (w < 0 ? -w : w);
+        if((denominator < 0 ? -denominator : denominator) <= tolerance * scale) return false;
+
+        for(Size i = 0; i < n; i++){
+            const Scalar a = Au[i] / denominator;
+            for(Size j = 0; j < n; j++) Ainv.data[i][j] -= a * vA[j];
+        }
+        return true;
+    } // end rank1UpdateInverse
+
+
+    /// @brief Updates Ainv = A^-1 to (A + U*V^T)^-1 in place with the Woodbury identity
+    /// @param Ainv the inverse of A, overwritten with the inverse of the updated matrix
+    /// @param U the n x k left factor of the update
+    /// @param V the n x k right factor of the update
+    /// @param tolerance the update is rejected if the smallest pivot of the k x k capacitance
+    /// matrix I + V^T Ainv U is at most tolerance * (1 + its largest element)
+    /// @return false if the update is unstable, in which case Ainv is unchanged
+    template<Size n, Size k, typename Scalar>
+    bool
+    rankKUpdateInverse(Matrix<n,n,Scalar> &Ainv, const Matrix<n,k,Scalar> &U, const Matrix<n,k,Scalar> &V,
+                       Scalar tolerance = Scalar(TMM_UPDATE_TOLERANCE))
+    {
+        // Ainv*U (n x k) and V^T*Ainv (k x n)
+        Matrix<n,k,Scalar> AU;
+        Matrix<k,n,Scalar> VA;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++)
+        for(Size p = 0; p < k; p++){
+            AU.data[i][p] += Ainv.data[i][j] * U.data[j][p];
+            VA.data[p][j] += V.data[i][p] * Ainv.data[i][j];
+        }
+
+        // Capacitance matrix I + V^T*Ainv*U
+        Matrix<k,k,Scalar> C = tmm::Identity<k,Scalar>();
+        Scalar largest = 0;
+        for(Size p = 0; p < k; p++)
+        for(Size r = 0; r < k; r++){
+            for(Size i = 0; i < n; i++) C.data[p][r] += V.data[i][p] * AU.data[i][r];
+            const Scalar c = C.data[p][r] < 0 ? -C.data[p][r] : C.data[p][r];
+            if(c > largest) largest = c;
+        }
+
+        Size pivots[k];
+        if(!tmm::luDecompose(C, pivots)) return false;
+        for(Size p = 0; p < k; p++){
+            const Scalar d = C.data[p][p] < 0 ? -C.data[p][p] : C.data[p][p];
+            if(d <= tolerance * (1 + largest)) return false;
+        }
+
+        // Ainv -= (Ainv*U) * C^-1 * (V^T*Ainv)
+        tmm::luSolve(C, pivots, VA);
+        for(Size i = 0; i < n; i++)
+        for(Size p = 0; p < k; p++){
+            const Scalar a = AU.data[i][p];
+            for(Size j = 0; j < n; j++) Ainv.data[i][j] -= a * VA.data[p][j];
+        }
+        return true;
+    } // end rankKUpdateInverse
+
+
+    /// @brief Inverts A from scratch with an LU decomposition
+    /// @return false if A is singular
+    template<Size n, typename Scalar>
+    bool
+    refactorInverse(const Matrix<n,n,Scalar> &A, Matrix<n,n,Scalar> &Ainv)
+    {
+        Matrix<n,n,Scalar> LU = A;
+        Size pivots[n];
+        if(!tmm::luDecompose(LU, pivots)) return false;
+        Ainv = tmm::Identity<n,Scalar>();
+        tmm::luSolve(LU, pivots, Ainv);
+        return true;
+    }
+
+
+    /// @brief Applies A += u*v^T and updates Ainv to match, refactoring A if the Sherman-Morrison update is unstable
+    /// @param A the matrix to update
+    /// @param Ainv the inverse of A, overwritten with the inverse of the updated matrix
+    /// @return false if the updated matrix is singular
+    template<Size n, typename Scalar>
+    bool
+    rank1UpdateInverse(Matrix<n,n,Scalar> &A, Matrix<n,n,Scalar> &Ainv, const Matrix<n,1,Scalar> &u, const Matrix<n,1,Scalar> &v,
+                       Scalar tolerance = Scalar(TMM_UPDATE_TOLERANCE))
+    {
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++)
+        A.data[i][j] += u.data[i][0] * v.data[j][0];
+
+        if(rank1UpdateInverse(Ainv, u, v, tolerance)) return true;
+        return refactorInverse(A, Ainv);
+    }
+
+
+    /// @brief Applies A += U*V^T and updates Ainv to match, refactoring A if the Woodbury update is unstable
+    /// @param A the matrix to update
+    /// @param Ainv the inverse of A, overwritten with the inverse of the updated matrix
+    /// @return false if the updated matrix is singular
+    template<Size n, Size k, typename Scalar>
+    bool
+    rankKUpdateInverse(Matrix<n,n,Scalar> &A, Matrix<n,n,Scalar> &Ainv, const Matrix<n,k,Scalar> &U, const Matrix<n,k,Scalar> &V,
+                       Scalar tolerance = Scalar(TMM_UPDATE_TOLERANCE))
+    {
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < n; j++)
+        for(Size p = 0; p < k; p++)
+        A.data[i][j] += U.data[i][p] * V.data[j][p];
+
+        if(rankKUpdateInverse(Ainv, U, V, tolerance)) return true;
+        return refactorInverse(A, Ainv);
+    }
+
+}
@@ -3,6 +3,7 @@
 
 
 #include "TMM_enable_if.hpp"
+#include "TMM_gemm.hpp"
 #ifdef ARDUINO
     
     #pragma weak dtostrf // for fixed-width float printing to serial to create uniform-looking matrices
@@ -15,8 +16,8 @@
 #endif
 #ifdef USING_STANDARD_LIBRARY // a macro defined in CMakeLists.txt
     #include <iostream>
-    #include <iomanip>
 #endif
+#include "TMM_text.hpp"
 
 
 namespace tmm{
@@ -24,6 +25,10 @@ namespace tmm{
 
     typedef unsigned char Size;
 
+    // Closed-form determinants and inverses for small matrices, defined in TMM_closed_form.hpp
+    template<Size n, typename Scalar>
+    struct ClosedForm;
+
     template<Size n, Size m, typename Scalar = float>
     class Matrix{
         public:
@@ -36,18 +41,28 @@ namespace tmm{
             data[i][j]=0;
         }
 
-        Matrix(const float M[n][m]){
+        /// @brief Copies a 2D array of any type that converts to Scalar
+        template<typename T>
+        Matrix(const T M[n][m]){
             for(Size i = 0; i < n; i++) 
             for(Size j = 0; j < m; j++) 
-            data[i][j]=M[i][j];
+            data[i][j]=Scalar(M[i][j]);
         }
 
-        Matrix(const float M){
+        Matrix(const Scalar M){
             for(Size i = 0; i < n; i++) 
             for(Size j = 0; j < m; j++) 
             data[i][j]=M;
         }
 
+        /// @brief Converts a matrix with another element type, as in Matrix<3,3,double>(float_matrix)
+        template<typename Other_Scalar>
+        explicit Matrix(const Matrix<n,m,Other_Scalar> &M){
+            for(Size i = 0; i < n; i++) 
+            for(Size j = 0; j < m; j++) 
+            data[i][j]=Scalar(M.data[i][j]);
+        }
+
 
         // Set this matrix to the value of another matrix
         void
@@ -92,11 +107,11 @@ namespace tmm{
         /// @param other the matrix to compare to
         /// @param tolerance the tolerance to use when comparing elements
         /// @return true if all elements of this matrix are equal to the elements of another matrix, within some tolerance
-        template<typename Other_Scalar>
-        bool equals(const Matrix<n,m,Scalar> &other, Scalar tolerance) const {
+        template<typename Other_Scalar = Scalar>
+        bool equals(const Matrix<n,m,Other_Scalar> &other, Scalar tolerance = Scalar(0)) const {
             for(Size i = 0; i < n; i++) 
             for(Size j = 0; j < m; j++){
-                Scalar comp = data[i][j]-other.data[i][j];
+                Scalar comp = data[i][j]-Scalar(other.data[i][j]);
                 if(comp < -tolerance || comp > tolerance) return false;
             }
             return true;
@@ -108,7 +123,7 @@ namespace tmm{
         /// @note For floating-point matrices, consider using equals() instead. equals() allows for a tolerance.
         template<typename Other_Scalar>
         bool operator==(const Matrix<n,m,Other_Scalar> &other) const {
-            return equals<Other_Scalar>(other, 0.f);
+            return equals<Other_Scalar>(other, Scalar(0));
         }
 
 
@@ -193,11 +208,33 @@ namespace tmm{
         operator *(const Matrix<m,q,Scalar> &other) const
         {
             Matrix<n,q,Scalar> M;
+            multiplyAccumulate(other, M);
+            return M;
+        }
+
+
+        /// @brief Adds the product of this matrix and another matrix to an output matrix (M += this * other)
+        /// @param other the right-hand side of the product
+        /// @param M the matrix to accumulate the product into
+        /// @note Small products use a simple loop. Large products are selected at compile time to use the blocked kernel in TMM_gemm.hpp.
+        template<Size q>
+        tmm::enable_if_t<!tmm::useBlockedProduct(n,m,q)>
+        multiplyAccumulate(const Matrix<m,q,Scalar> &other, Matrix<n,q,Scalar> &M) const
+        {
             for(Size i = 0; i < n; i++) 
             for(Size j = 0; j < q; j++) 
             for(Size k = 0; k < m; k++) 
             M[i][j]+=data[i][k]*other.data[k][j];
-            return M;
+        }
+
+        template<Size q>
+        tmm::enable_if_t<tmm::useBlockedProduct(n,m,q)>
+        multiplyAccumulate(const Matrix<m,q,Scalar> &other, Matrix<n,q,Scalar> &M) const
+        {
+            tmm::gemm<Scalar>(n, q, m, Scalar(1),
+                &data[0][0], m, 1,
+                &other.data[0][0], q, 1,
+                &M.data[0][0], q);
         }
 
         
@@ -368,54 +405,97 @@ namespace tmm{
             other[i][j]=data[i][j];
         }
 
-        // Implementation-specific functions
-        #ifdef ARDUINO
+        /// @brief Writes this matrix as text through a buffered writer
+        /// @tparam Writer TextWriter, PrintWriter, or anything with put(char) and scalar(value, precision)
+        /// @param writer the writer to send the text to
+        /// @param format the layout and number of decimal places to use
+        template<typename Writer>
         void
-        printTo(Print &serial) const
+        formatTo(Writer &writer, TextFormat format = TextFormat()) const
         {
+            const bool json = format.layout == TextLayout::JSON;
+            const char separator = format.layout == TextLayout::TSV ? '\t' : ',';
+            if(json) writer.put('[');
             for(Size i = 0; i < n; i++) 
             {
+                if(json) writer.put('[');
                 for(Size j = 0; j < m; j++) 
                 {
-                    if(dtostrf_func){
-                        char buf[7];
-                        dtostrf_func(data[i][j], 6, 3, buf);
-                        serial.print(buf);
-                    }
-                    else{
-                        serial.print(data[i][j]);
-                    }
-                    serial.print("\t");
+                    if(j) writer.put(separator);
+                    writer.scalar(data[i][j], format.precision);
                 }
-                serial.println();
+                if(json){
+                    writer.put(']');
+                    if(i+1 < n) writer.put(',');
+                }
+                else writer.put('\n');
+            }
+            if(json){
+                writer.put(']');
+                writer.put('\n');
             }
+        } // end formatTo
+
+        // Implementation-specific functions
+        #ifdef ARDUINO
+        void
+        printTo(Print &serial, TextFormat format = TextFormat()) const
+        {
+            PrintWriter writer(serial);
+            formatTo(writer, format);
         } // end printTo
         #endif
         #ifdef USING_STANDARD_LIBRARY
+        /// @brief Writes this matrix to a stream without flushing it
+        /// @note To write many matrices, create one TextWriter and call formatTo() instead.
         void
-        printTo(std::ostream &out) const
+        printTo(std::ostream &out, TextFormat format = TextFormat()) const
+        {
+            char storage[256];
+            TextWriter writer(out, storage, sizeof(storage));
+            formatTo(writer, format);
+        }
+
+        /// @brief Reads the next n*m numbers from a reader into this matrix, in row-major order
+        /// @return false if the reader ran out of numbers, in which case this matrix is partially overwritten
+        bool
+        readFrom(TextReader &in)
         {
             for(Size i = 0; i < n; i++) 
-            {
-                for(Size j = 0; j < m; j++) 
-                {
-                    out << std::setw(6) << data[i][j];
-                    out << "\t";
-                }
-                out << std::endl;
-            }
+            for(Size j = 0; j < m; j++) 
+            if(!in.next(data[i][j])) return false;
+            return true;
         }
         #endif
 
 
+        /// @brief Returns the determinant of a 2x2, 3x3 or 4x4 matrix, in closed form
+        template <typename T = Scalar, Size N = n>
+        tmm::enable_if_t<(m==N && N>=2 && N<=4), T>
+        determinant() const
+        {
+            return ClosedForm<n,Scalar>::determinant(*this);
+        }
+
+
+        /// @brief Inverts a 2x2, 3x3 or 4x4 matrix in closed form
+        /// @param result the matrix to store the inverse in
+        /// @return false if the matrix is singular, in which case result holds infinities or NaNs
+        template <typename T = bool, Size N = n>
+        tmm::enable_if_t<(m==N && N>=2 && N<=4), T>
+        inverse(Matrix<n,n,Scalar> &result) const
+        {
+            return ClosedForm<n,Scalar>::inverse(*this, result);
+        }
+
+
         #ifndef TMM_DISABLE_RECURSIVE
-        template <typename T = Scalar>
-        tmm::enable_if_t<(m==n), T>
+        template <typename T = Scalar, Size N = n>
+        tmm::enable_if_t<(m==N && (N<2 || N>4)), T>
         determinant() const
         {
             if(n == 0) { return 1; }
             if(n == 1) { return Matrix<n,n,Scalar>::data[0][0]; }
-            if(n == 2) { return Matrix<n,n,Scalar>::data[0][0] * Matrix<n,n,Scalar>::data[1][1] - Matrix<n,n,Scalar>::data[0][1] * Matrix<n,n,Scalar>::data[1][0]; }
             Scalar sign = 1;
             Scalar ret  = 0;
             for(Size i = 0; i < n; i++){
@@ -432,7 +512,7 @@ namespace tmm{
                     }
                     // skip the i'th column
                     for(Size q = i+1; q < n; q++){
-                        submatrix[p][q]=Matrix<n,n,Scalar>::data[p+1][q-1];
+                        submatrix[p][q-1]=Matrix<n,n,Scalar>::data[p+1][q];
                     }
                 }
                 // end of code snippet
@@ -456,33 +536,21 @@ namespace tmm{
                     //  Take the determinant of the matrix
                     // formed by all elements that are not
                     // in the i'th row or the j'th column.
-                    //
-                    //  Construct a temporary matrix with these
-                    // values so we can take the determinant 
-                    // of it.
-                    //
-                    // TODO simplify this garbage
-                    Matrix<n-1,n-1,Scalar> t;
-                    for(Size p = 0; p < i; p ++){
-                        for(Size q = 0; q < j; q++){
-                            t[p][q]=Matrix<n,n,Scalar>::data[p][q];
-                        }
-                        for(Size q = j+1; q < n; q++){
-                            t[p][q]=Matrix<n,n,Scalar>::data[p][q-1];
-                        }
-                    }
-                    for(Size p = i+1; p < n; p ++){
+                    Matrix<(n>0?n-1:n),(n>0?n-1:n),Scalar> t;
+                    for(Size p = 0; p < n; p ++){
+                        if(p == i) continue;
+                        const Size tp = p < i ? p : p-1;
                         for(Size q = 0; q < j; q++){
-                            t[p-1][q]=Matrix<n,n,Scalar>::data[p-1][q];
+                            t[tp][q]=Matrix<n,n,Scalar>::data[p][q];
                         }
                         for(Size q = j+1; q < n; q++){
-                            t[p-1][q]=Matrix<n,n,Scalar>::data[p-1][q-1];
+                            t[tp][q-1]=Matrix<n,n,Scalar>::data[p][q];
                         }
                     }
                     M[i][j] = t.determinant();
 
                     // Without this line, M would be a matrix of minors
-                    if (i+j%2==1) M[i][j] = -M[i][j];
+                    if ((i+j)%2==1) M[i][j] = -M[i][j];
                 }
             }
             return M;
@@ -491,26 +559,37 @@ namespace tmm{
 
 
 
+        /// @brief Attempts to invert the matrix with its adjugate, reporting whether it is singular
+        /// @param result the matrix to store the inverse in
+        /// @return false if the matrix is singular
+        template <typename T = bool, Size N = n>
+        tmm::enable_if_t<(m==N && (N<2 || N>4)), T>
+        inverse(Matrix<n,n,Scalar> &result) const
+        {
+            // The matrix is the adjugate divided by the determinant,
+            // where the adjugate is the cofactor transposed
+            const Scalar det = determinant();
+            if(det == 0) return false;
+            result = cofactor().transpose() / det;
+            return true;
+        }
+        #endif // ifndef DISABLE_RECURSIVE 
+
+
         /// @brief Attempts to invert the matrix
-        /// @tparam T a helper parameter that ensures this function is only available on small matrices. (No need to set it.)
+        /// @tparam T a helper parameter that ensures this function is only available on square matrices. (No need to set it.)
         /// @return an inverted matrix
-        /// @warning This method is not implemented correctly yet.
-        /// @todo fix and test this method
+        /// @note Use inverse(result) to find out whether the matrix was singular.
         template <typename T = Matrix<n,n,Scalar>>
         tmm::enable_if_t<(m==n), T>
         inverse() const
         {
-            // The matrix is the adjugate divided by the determinant,
-            // where the adjugate is the cofactor transposed
-            Matrix<n,n,Scalar> adjugate = cofactor().transpose();
-            
-            return adjugate / determinant();
+            Matrix<n,n,Scalar> result;
+            inverse(result);
+            return result;
         } // end inverse
 
 
-    #endif // ifndef DISABLE_RECURSIVE 
-
-
 
     }; // end Matrix class
 
@@ -534,3 +613,4 @@ namespace tmm{
 
 }
 
+#include "TMM_closed_form.hpp"
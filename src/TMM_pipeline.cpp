@@ -0,0 +1,110 @@
+#include "TMM_pipeline.hpp"
+
+#if defined(USING_STANDARD_LIBRARY) && defined(TMM_ENABLE_THREADS)
+
+namespace tmm{
+
+    PipelineStageStats
+    PipelineStage::stats(long long now) const
+    {
+        PipelineStageStats result;
+        result.name    = name;
+        result.frames  = frames.load(std::memory_order_relaxed);
+        result.dropped = dropped.load(std::memory_order_relaxed);
+        result.stalls  = stalls.load(std::memory_order_relaxed);
+        result.starves = starves.load(std::memory_order_relaxed);
+        result.waits   = waits.load(std::memory_order_relaxed);
+        result.busySeconds = busy.load(std::memory_order_relaxed) * 1e-9;
+
+        const long long finished = finishedAt.load(std::memory_order_acquire);
+        const long long elapsed = (finished ? finished : now) - pipeline.startedAt;
+        if(elapsed > 0) result.throughput = result.frames / (elapsed * 1e-9);
+        if(result.frames){
+            result.meanLatency = latencySum.load(std::memory_order_relaxed) * 1e-9 / result.frames;
+            result.maxLatency  = latencyMax.load(std::memory_order_relaxed) * 1e-9;
+        }
+        return result;
+    }
+
+
+    bool
+    PipelineStage::stopping() const
+    {
+        return pipeline.stopping.load(std::memory_order_relaxed);
+    }
+
+
+    std::size_t
+    PipelineStage::batch() const
+    {
+        return pipeline.batchSize;
+    }
+
+
+    void
+    PipelineStage::record(std::size_t count, std::size_t rejected, long long begin, long long end, long long sum, long long worst)
+    {
+        // Only this stage's thread writes its counters, so plain loads and stores are enough
+        frames.store(frames.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        dropped.store(dropped.load(std::memory_order_relaxed) + rejected, std::memory_order_relaxed);
+        busy.store(busy.load(std::memory_order_relaxed) + (end - begin), std::memory_order_relaxed);
+        latencySum.store(latencySum.load(std::memory_order_relaxed) + sum, std::memory_order_relaxed);
+        if(worst > latencyMax.load(std::memory_order_relaxed)) latencyMax.store(worst, std::memory_order_relaxed);
+    }
+
+
+
+    Pipeline::Pipeline(std::size_t capacity, std::size_t batch)
+        : capacity(capacity ? capacity : 1), batchSize(batch ? batch : 1) {}
+
+
+    Pipeline::~Pipeline(){
+        stop();
+        wait();
+    }
+
+
+    bool
+    Pipeline::start(){
+        if(started) return false;
+        for(const int *consumers : consumerCounts) if(*consumers != 1) return false;
+
+        started = true;
+        startedAt = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        for(std::unique_ptr<PipelineStage> &stage : stages){
+            PipelineStage *s = stage.get();
+            s->thread = std::thread([s]{
+                s->run();
+                s->finishedAt.store(PipelineStage::clock(), std::memory_order_release);
+            });
+        }
+        return true;
+    }
+
+
+    void
+    Pipeline::stop(){
+        stopping.store(true, std::memory_order_relaxed);
+    }
+
+
+    void
+    Pipeline::wait(){
+        for(std::unique_ptr<PipelineStage> &stage : stages){
+            if(stage->thread.joinable()) stage->thread.join();
+        }
+    }
+
+
+    std::vector<PipelineStageStats>
+    Pipeline::stats() const
+    {
+        const long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        std::vector<PipelineStageStats> result;
+        for(const std::unique_ptr<PipelineStage> &stage : stages) result.push_back(stage->stats(now));
+        return result;
+    }
+
+}
+
+#endif // if defined(USING_STANDARD_LIBRARY) && defined(TMM_ENABLE_THREADS)
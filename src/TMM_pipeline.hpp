@@ -0,0 +1,495 @@
+// A streaming pipeline for processing a continuous flow of matrices on the host.
+//
+// Each stage of a Pipeline runs on its own thread. Consecutive stages are
+// connected by a RingBuffer: a bounded, lock-free single-producer/single-consumer
+// queue whose slots are allocated once, when the pipeline is built. Stages
+// write their results straight into the next stage's slots, so no matrices
+// are allocated or copied between stages after that. When a ring is full,
+// its producer waits (backpressure), so a slow stage slows the whole pipeline
+// down instead of letting a queue grow without bound.
+//
+//     tmm::Pipeline pipeline(64, 8);  // 64 slots per link, up to 8 frames per batch
+//     auto &raw      = pipeline.source<tmm::Matrix<16,1>>("receive", receive);
+//     auto &decoded  = pipeline.stage<tmm::Matrix<6,1>>("decode", raw, decode);
+//     pipeline.sink("write", decoded, write);
+//     pipeline.start();
+//     pipeline.wait();  // returns once receive() reports the end of the stream
+//
+// RingBuffer is available whenever the standard library is. Pipeline needs
+// TMM_ENABLE_THREADS (the CMake option tinymatrixmath_ENABLE_THREADS).
+
+#pragma once
+
+#ifdef USING_STANDARD_LIBRARY
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+namespace tmm{
+
+    /// @brief A bounded, lock-free queue between one producer thread and one consumer thread
+    /// @tparam T the element type. All slots are default-constructed up front and reused.
+    /// @note The producer fills writeSlot(0..k-1) and then calls publish(k). The consumer reads
+    /// readSlot(0..k-1) and then calls release(k). Publishing and releasing several slots at
+    /// once (batching) costs one atomic store, no matter how many slots there are.
+    template<typename T>
+    class RingBuffer{
+        public:
+
+        /// @param capacity the number of slots, rounded up to a power of two
+        explicit RingBuffer(std::size_t capacity) : slots(roundUp(capacity)), mask(slots.size() - 1) {}
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        std::size_t capacity() const { return slots.size(); }
+
+
+        // Producer side
+
+        /// @brief The number of slots the producer can fill
+        /// @param wanted the consumer's position is only re-read (an access to a shared cache line)
+        /// when fewer than this many slots are known to be free
+        std::size_t
+        writable(std::size_t wanted = 1)
+        {
+            const std::size_t head = this->head.load(std::memory_order_relaxed);
+            std::size_t free = slots.size() - (head - tailCache);
+            if(free < wanted){
+                tailCache = tail.load(std::memory_order_acquire);
+                free = slots.size() - (head - tailCache);
+            }
+            return free;
+        }
+
+        /// @brief The i-th free slot, for i < writable()
+        T& writeSlot(std::size_t i){ return slots[(head.load(std::memory_order_relaxed) + i) & mask]; }
+
+        /// @brief Hands the first count free slots to the consumer
+        void publish(std::size_t count){ head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+
+        /// @brief Tells the consumer nothing more will be published
+        void close(){ closedFlag.store(true, std::memory_order_release); }
+
+        bool
+        tryPush(const T &value)
+        {
+            if(!writable()) return false;
+            writeSlot(0) = value;
+            publish(1);
+            return true;
+        }
+
+
+        // Consumer side
+
+        /// @brief The number of slots the consumer can read
+        /// @param wanted the producer's position is only re-read when fewer than this many slots are known to be full
+        std::size_t
+        readable(std::size_t wanted = 1)
+        {
+            const std::size_t tail = this->tail.load(std::memory_order_relaxed);
+            std::size_t full = headCache - tail;
+            if(full < wanted){
+                headCache = head.load(std::memory_order_acquire);
+                full = headCache - tail;
+            }
+            return full;
+        }
+
+        /// @brief The i-th full slot, for i < readable()
+        T& readSlot(std::size_t i){ return slots[(tail.load(std::memory_order_relaxed) + i) & mask]; }
+
+        /// @brief Hands the first count full slots back to the producer
+        void release(std::size_t count){ tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+
+        /// @brief True once the producer has closed the ring. Anything it published before that is still readable.
+        bool closed() const { return closedFlag.load(std::memory_order_acquire); }
+
+        bool
+        tryPop(T &value)
+        {
+            if(!readable()) return false;
+            value = readSlot(0);
+            release(1);
+            return true;
+        }
+
+        private:
+
+        static std::size_t
+        roundUp(std::size_t capacity)
+        {
+            std::size_t size = 1;
+            while(size < capacity) size *= 2;
+            return size;
+        }
+
+        std::vector<T> slots;
+        const std::size_t mask;
+
+        // The producer's and the consumer's positions live on separate cache lines,
+        // each next to the producer's or consumer's cached copy of the other's position
+        char padding0[64];
+        std::atomic<std::size_t> head{0};
+        std::size_t tailCache = 0;
+        char padding1[64];
+        std::atomic<std::size_t> tail{0};
+        std::size_t headCache = 0;
+        char padding2[64];
+        std::atomic<bool> closedFlag{false};
+    }; // end RingBuffer class
+
+}
+
+#endif // ifdef USING_STANDARD_LIBRARY
+
+
+
+#if defined(USING_STANDARD_LIBRARY) && defined(TMM_ENABLE_THREADS)
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+// The longest a waiting stage sleeps before checking its links again, in microseconds.
+// This bounds the latency added to the first frame after an idle period.
+#ifndef TMM_PIPELINE_MAX_SLEEP
+    #define TMM_PIPELINE_MAX_SLEEP 1000
+#endif
+
+
+namespace tmm{
+
+    class Pipeline;
+
+
+    /// @brief A snapshot of one stage's counters
+    struct PipelineStageStats{
+        std::string name;
+        unsigned long long frames = 0;   // frames produced (sources) or consumed (other stages)
+        unsigned long long dropped = 0;  // frames a stage function rejected
+        unsigned long long stalls = 0;   // times the stage waited for space in its output link (backpressure)
+        unsigned long long starves = 0;  // times the stage waited for input
+        unsigned long long waits = 0;    // times a waiting stage checked its links again
+        double busySeconds = 0;          // time spent running the stage function
+        double throughput = 0;           // frames per second, from start() until now or until the stage finished
+        double meanLatency = 0;          // seconds from a frame leaving the source to this stage finishing it
+        double maxLatency = 0;
+    };
+
+
+    /// @brief A link between two stages: a ring of frames stamped with the time they left the source
+    template<typename T>
+    class PipelineLink{
+        public:
+
+        struct Frame{
+            T value;
+            long long stamp = 0; // nanoseconds on the steady clock
+        };
+
+        explicit PipelineLink(std::size_t capacity) : ring(capacity) {}
+
+        RingBuffer<Frame> ring;
+        int consumers = 0;
+    };
+
+
+    /// @brief The counters and thread shared by every kind of stage
+    class PipelineStage{
+        public:
+
+        PipelineStage(Pipeline &pipeline, const char *name) : pipeline(pipeline), name(name) {}
+        virtual ~PipelineStage() {}
+
+        virtual void run() = 0;
+
+        PipelineStageStats stats(long long now) const;
+
+        protected:
+
+        static long long
+        clock()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Waits until the link has something to read. Returns 0 once it is closed and empty.
+        template<typename T>
+        std::size_t
+        waitForInput(PipelineLink<T> &input, std::size_t batch)
+        {
+            for(unsigned int spins = 0; ; spins++){
+                const std::size_t count = input.ring.readable(batch);
+                if(count) return count < batch ? count : batch;
+                if(input.ring.closed() && !input.ring.readable()) return 0;
+                if(!spins) starves.fetch_add(1, std::memory_order_relaxed);
+                backoff(spins);
+            }
+        }
+
+        // Waits until the link has room for at least one frame. Returns 0 if the pipeline is stopped while a source waits.
+        template<typename T>
+        std::size_t
+        waitForSpace(PipelineLink<T> &output, std::size_t batch, bool source)
+        {
+            for(unsigned int spins = 0; ; spins++){
+                const std::size_t count = output.ring.writable(batch);
+                if(count) return count < batch ? count : batch;
+                if(source && stopping()) return 0;
+                if(!spins) stalls.fetch_add(1, std::memory_order_relaxed);
+                backoff(spins);
+            }
+        }
+
+        // Spins briefly, then yields, then sleeps for twice as long each time up to TMM_PIPELINE_MAX_SLEEP,
+        // so a stage waiting on a slow neighbour doesn't keep a core busy
+        void
+        backoff(unsigned int spins)
+        {
+            waits.fetch_add(1, std::memory_order_relaxed);
+            if(spins < 64) return;
+            if(spins < 128){
+                std::this_thread::yield();
+                return;
+            }
+            const unsigned int doublings = spins - 128;
+            const long long sleep = doublings < 20 && (1LL << doublings) < TMM_PIPELINE_MAX_SLEEP ? 1LL << doublings : TMM_PIPELINE_MAX_SLEEP;
+            std::this_thread::sleep_for(std::chrono::microseconds(sleep));
+        }
+
+        bool stopping() const;
+        std::size_t batch() const;
+
+        // Adds a finished batch to the counters
+        void record(std::size_t frames, std::size_t dropped, long long begin, long long end, long long latencySum, long long latencyMax);
+
+        Pipeline &pipeline;
+        std::string name;
+        std::thread thread;
+        std::atomic<unsigned long long> frames{0}, dropped{0}, stalls{0}, starves{0}, waits{0};
+        std::atomic<long long> busy{0}, latencySum{0}, latencyMax{0};
+        std::atomic<long long> finishedAt{0};
+
+        friend class Pipeline;
+    }; // end PipelineStage class
+
+
+    // Produces frames until produce() returns false
+    template<typename Out, typename F>
+    class PipelineSource : public PipelineStage{
+        public:
+
+        PipelineSource(Pipeline &pipeline, const char *name, PipelineLink<Out> &output, F produce)
+            : PipelineStage(pipeline, name), output(output), produce(produce) {}
+
+        void
+        run() override
+        {
+            for(bool more = true; more && !stopping(); ){
+                const std::size_t count = waitForSpace(output, batch(), true);
+                if(!count) break;
+                const long long begin = clock();
+                std::size_t produced = 0;
+                while(produced < count && (more = produce(output.ring.writeSlot(produced).value))) produced++;
+                const long long end = clock();
+                for(std::size_t i = 0; i < produced; i++) output.ring.writeSlot(i).stamp = end;
+                output.ring.publish(produced);
+                record(produced, 0, begin, end, 0, 0);
+            }
+            output.ring.close();
+        }
+
+        private:
+
+        PipelineLink<Out> &output;
+        F produce;
+    };
+
+
+    // Applies transform() to every frame, dropping the frames it returns false for
+    template<typename In, typename Out, typename F>
+    class PipelineTransform : public PipelineStage{
+        public:
+
+        PipelineTransform(Pipeline &pipeline, const char *name, PipelineLink<In> &input, PipelineLink<Out> &output, F transform)
+            : PipelineStage(pipeline, name), input(input), output(output), transform(transform) {}
+
+        void
+        run() override
+        {
+            for(;;){
+                std::size_t count = waitForInput(input, batch());
+                if(!count) break;
+                const std::size_t space = waitForSpace(output, count, false);
+                if(space < count) count = space;
+
+                const long long begin = clock();
+                std::size_t written = 0;
+                for(std::size_t i = 0; i < count; i++){
+                    typename PipelineLink<In>::Frame &in = input.ring.readSlot(i);
+                    typename PipelineLink<Out>::Frame &out = output.ring.writeSlot(written);
+                    if(transform(in.value, out.value)){
+                        out.stamp = in.stamp;
+                        written++;
+                    }
+                }
+                const long long end = clock();
+
+                long long sum = 0, worst = 0;
+                for(std::size_t i = 0; i < count; i++){
+                    const long long latency = end - input.ring.readSlot(i).stamp;
+                    sum += latency;
+                    if(latency > worst) worst = latency;
+                }
+                output.ring.publish(written);
+                input.ring.release(count);
+                record(count, count - written, begin, end, sum, worst);
+            }
+            output.ring.close();
+        }
+
+        private:
+
+        PipelineLink<In> &input;
+        PipelineLink<Out> &output;
+        F transform;
+    };
+
+
+    // Passes every frame to consume()
+    template<typename In, typename F>
+    class PipelineSink : public PipelineStage{
+        public:
+
+        PipelineSink(Pipeline &pipeline, const char *name, PipelineLink<In> &input, F consume)
+            : PipelineStage(pipeline, name), input(input), consume(consume) {}
+
+        void
+        run() override
+        {
+            for(;;){
+                const std::size_t count = waitForInput(input, batch());
+                if(!count) break;
+                const long long begin = clock();
+                for(std::size_t i = 0; i < count; i++) consume(input.ring.readSlot(i).value);
+                const long long end = clock();
+
+                long long sum = 0, worst = 0;
+                for(std::size_t i = 0; i < count; i++){
+                    const long long latency = end - input.ring.readSlot(i).stamp;
+                    sum += latency;
+                    if(latency > worst) worst = latency;
+                }
+                input.ring.release(count);
+                record(count, 0, begin, end, sum, worst);
+            }
+        }
+
+        private:
+
+        PipelineLink<In> &input;
+        F consume;
+    };
+
+
+
+    /// @brief A chain of stages, each running on its own thread, connected by bounded ring buffers
+    class Pipeline{
+        public:
+
+        /// @param capacity the number of preallocated frames in each link between stages
+        /// @param batch the most frames a stage handles before publishing its results.
+        /// Larger batches mean less synchronization between threads but higher latency.
+        explicit Pipeline(std::size_t capacity = 64, std::size_t batch = 1);
+
+        /// @brief Stops the sources and waits for every stage to finish
+        ~Pipeline();
+
+        Pipeline(const Pipeline&) = delete;
+        Pipeline& operator=(const Pipeline&) = delete;
+
+        /// @brief Adds a stage that produces frames
+        /// @param produce called as bool produce(Out &frame). It fills in the frame and returns true,
+        /// or returns false at the end of the stream.
+        /// @return the link to the stage's output, to pass to the next stage
+        template<typename Out, typename F>
+        PipelineLink<Out>&
+        source(const char *name, F produce)
+        {
+            PipelineLink<Out> &output = addLink<Out>();
+            stages.emplace_back(new PipelineSource<Out,F>(*this, name, output, produce));
+            return output;
+        }
+
+        /// @brief Adds a stage that turns each frame from a link into a new frame
+        /// @param transform called as bool transform(const In &in, Out &out). It fills in out and returns true,
+        /// or returns false to drop the frame.
+        /// @return the link to the stage's output, to pass to the next stage
+        template<typename Out, typename In, typename F>
+        PipelineLink<Out>&
+        stage(const char *name, PipelineLink<In> &input, F transform)
+        {
+            input.consumers++;
+            PipelineLink<Out> &output = addLink<Out>();
+            stages.emplace_back(new PipelineTransform<In,Out,F>(*this, name, input, output, transform));
+            return output;
+        }
+
+        /// @brief Adds a final stage
+        /// @param consume called as consume(const In &frame) for every frame
+        template<typename In, typename F>
+        void
+        sink(const char *name, PipelineLink<In> &input, F consume)
+        {
+            input.consumers++;
+            stages.emplace_back(new PipelineSink<In,F>(*this, name, input, consume));
+        }
+
+        /// @brief Starts one thread per stage
+        /// @return false if the pipeline was already started, or if a link doesn't have exactly one consumer
+        bool start();
+
+        /// @brief Asks the sources to stop. Frames already produced still go through the rest of the pipeline.
+        void stop();
+
+        /// @brief Waits for every stage to finish
+        void wait();
+
+        /// @brief The counters of every stage, in the order the stages were added
+        /// @note This can be called while the pipeline runs.
+        std::vector<PipelineStageStats> stats() const;
+
+        std::size_t batch() const { return batchSize; }
+
+        private:
+
+        template<typename T>
+        PipelineLink<T>&
+        addLink()
+        {
+            PipelineLink<T> *link = new PipelineLink<T>(capacity);
+            links.emplace_back(link, [](void *p){ delete static_cast<PipelineLink<T>*>(p); });
+            consumerCounts.push_back(&link->consumers);
+            return *link;
+        }
+
+        const std::size_t capacity;
+        const std::size_t batchSize;
+        std::vector<std::unique_ptr<void, void(*)(void*)>> links;
+        std::vector<std::unique_ptr<PipelineStage>> stages;
+        std::vector<const int*> consumerCounts;
+        std::atomic<bool> stopping{false};
+        bool started = false;
+        long long startedAt = 0;
+
+        friend class PipelineStage;
+    }; // end Pipeline class
+
+}
+
+#endif // if defined(USING_STANDARD_LIBRARY) && defined(TMM_ENABLE_THREADS)
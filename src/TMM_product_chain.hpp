@@ -0,0 +1,202 @@
+// Lazy products of several matrices, evaluated in the cheapest order.
+//
+// A * B * v is evaluated left to right, so with 6x6 matrices A and B and a
+// 6x1 vector v it takes a 6x6x6 product before the 6x6x1 one, when
+// A * (B * v) would take two 6x6x1 products. Writing
+//     tmm::Matrix<6,1> r = tmm::chain(A) * B * v;
+// instead builds a ProductChain that only records its factors. When it is
+// assigned to a matrix, the chain is multiplied out in the order that takes
+// the fewest multiply-adds. That order is found with the textbook
+// matrix-chain algorithm over the template dimensions, so it is fixed at
+// compile time and costs nothing at run time.
+//
+// The chain holds pointers to its factors, so it must be assigned in the
+// same statement that builds it. Don't store one with auto.
+
+#pragma once
+
+#include "TMM_matrix.hpp"
+
+
+namespace tmm{
+
+
+    /// @brief The i-th value in a list of dimensions
+    template<int i, Size... dims>
+    struct ChainDim;
+
+    template<Size first, Size... rest>
+    struct ChainDim<0, first, rest...>{
+        static const Size value = first;
+    };
+
+    template<int i, Size first, Size... rest>
+    struct ChainDim<i, first, rest...>{
+        static const Size value = ChainDim<i-1, rest...>::value;
+    };
+
+
+    template<int i, int j, int k, bool last, Size... dims>
+    struct ChainSplit;
+
+    /// @brief The cheapest way to multiply factors i..j of a chain, where factor f is dims[f] x dims[f+1]
+    /// @note cost is the number of multiply-adds. The chain is split into (i..split) * (split+1..j).
+    /// Each ChainOrder is only instantiated once per chain, which memoizes the search.
+    template<int i, int j, Size... dims>
+    struct ChainOrder{
+        typedef ChainSplit<i, j, i, i+1 == j, dims...> Best;
+        static const unsigned long cost = Best::cost;
+        static const int split = Best::split;
+    };
+
+    template<int i, Size... dims>
+    struct ChainOrder<i, i, dims...>{
+        static const unsigned long cost = 0;
+        static const int split = i;
+    };
+
+    template<int i, int j, Size... dims> const unsigned long ChainOrder<i, j, dims...>::cost;
+    template<int i, int j, Size... dims> const int ChainOrder<i, j, dims...>::split;
+    template<int i, Size... dims> const unsigned long ChainOrder<i, i, dims...>::cost;
+    template<int i, Size... dims> const int ChainOrder<i, i, dims...>::split;
+
+
+    /// @brief The cheapest of the splits k..j-1 of factors i..j. Ties go to the leftmost split.
+    template<int i, int j, int k, bool last, Size... dims>
+    struct ChainSplit{
+        typedef ChainSplit<i, j, k+1, k+2 == j, dims...> Next;
+        static const unsigned long here = ChainOrder<i, k, dims...>::cost + ChainOrder<k+1, j, dims...>::cost
+            + (unsigned long)ChainDim<i, dims...>::value * ChainDim<k+1, dims...>::value * ChainDim<j+1, dims...>::value;
+        static const unsigned long cost = here <= Next::cost ? here : Next::cost;
+        static const int split = here <= Next::cost ? k : Next::split;
+    };
+
+    template<int i, int j, int k, Size... dims>
+    struct ChainSplit<i, j, k, true, dims...>{
+        static const unsigned long cost = ChainOrder<i, k, dims...>::cost + ChainOrder<k+1, j, dims...>::cost
+            + (unsigned long)ChainDim<i, dims...>::value * ChainDim<k+1, dims...>::value * ChainDim<j+1, dims...>::value;
+        static const int split = k;
+    };
+
+
+
+    /// @brief An unevaluated product of matrices, where factor f is dims[f] x dims[f+1]
+    /// @note Build one with tmm::chain(A) * B * ..., and assign it to a matrix to evaluate it.
+    template<typename Scalar, Size... dims>
+    class ProductChain{
+        public:
+
+        static const int count = sizeof...(dims) - 1; // number of factors
+
+        /// @brief The product of factors i..j
+        template<int i, int j>
+        using Block = Matrix<ChainDim<i, dims...>::value, ChainDim<j+1, dims...>::value, Scalar>;
+
+        typedef Block<0, count-1> Result;
+
+        /// @brief Multiply-adds taken to evaluate the chain in the cheapest order
+        static const unsigned long cost = ChainOrder<0, count-1, dims...>::cost;
+
+
+        explicit ProductChain(const Block<0,0> &first){
+            factors[0] = &first;
+        }
+
+
+        /// @brief Appends a factor to the chain. Its row count must match the column count of the last factor.
+        template<Size q>
+        ProductChain<Scalar, dims..., q>
+        operator *(const Matrix<ChainDim<count, dims...>::value, q, Scalar> &other) const
+        {
+            return ProductChain<Scalar, dims..., q>(factors, &other);
+        }
+
+
+        /// @brief Multiplies the chain out in the cheapest order
+        /// @param M the output matrix. It must not be one of the factors.
+        void
+        evaluateTo(Result &M) const
+        {
+            M = Scalar(0);
+            accumulate<0, count-1>(M);
+        }
+
+
+        operator Result() const
+        {
+            Result M;
+            accumulate<0, count-1>(M);
+            return M;
+        }
+
+
+        private:
+
+        template<typename, Size...> friend class ProductChain;
+
+        // Copies the factors of a shorter chain and appends one. A chain of one factor
+        // has no shorter chain, and is left without this constructor so the prefix is never a zero-length array.
+        template<int c = count, typename = tmm::enable_if_t<(c > 1)>>
+        ProductChain(const void *const (&prefix)[c-1], const void *last){
+            for(int f = 0; f < count-1; f++) factors[f] = prefix[f];
+            factors[count-1] = last;
+        }
+
+        // Each factor is stored without its type, which is recovered from dims when it is read
+        template<int i>
+        const Block<i,i>&
+        factor() const
+        {
+            return *static_cast<const Block<i,i>*>(factors[i]);
+        }
+
+
+        // A factor, used in place, or a product of factors, evaluated into a temporary
+        template<int i, int j, bool single = (i == j)>
+        struct Operand{
+            Block<i,j> value;
+            explicit Operand(const ProductChain &chain){ chain.template accumulate<i,j>(value); }
+        };
+
+        template<int i, int j>
+        struct Operand<i, j, true>{
+            const Block<i,j> &value;
+            explicit Operand(const ProductChain &chain) : value(chain.template factor<i>()) {}
+        };
+
+
+        // M += the product of factors i..j, split as ChainOrder chose
+        template<int i, int j>
+        tmm::enable_if_t<(i < j)>
+        accumulate(Block<i,j> &M) const
+        {
+            const int k = ChainOrder<i, j, dims...>::split;
+            const Operand<i, k> left(*this);
+            const Operand<k+1, j> right(*this);
+            left.value.multiplyAccumulate(right.value, M);
+        }
+
+        template<int i, int j>
+        tmm::enable_if_t<(i == j)>
+        accumulate(Block<i,j> &M) const
+        {
+            M = M + factor<i>();
+        }
+
+
+        const void *factors[count];
+    }; // end ProductChain class
+
+    template<typename Scalar, Size... dims> const int ProductChain<Scalar, dims...>::count;
+    template<typename Scalar, Size... dims> const unsigned long ProductChain<Scalar, dims...>::cost;
+
+
+    /// @brief Starts a lazy product chain, as in tmm::chain(A) * B * v
+    template<Size n, Size m, typename Scalar>
+    ProductChain<Scalar, n, m>
+    chain(const Matrix<n,m,Scalar> &A)
+    {
+        return ProductChain<Scalar, n, m>(A);
+    }
+
+}
@@ -0,0 +1,377 @@
+// Quantized int8 matrix products for small neural-network layers.
+//
+// A real-valued matrix is stored as int8 values q with an affine mapping
+//     real = scale * (q - zero)
+// which takes a quarter of the RAM of floats. The product of two int8
+// matrices is accumulated exactly in int32. It is then requantized to int8
+// with a fixed-point multiplier, so no floating point is used at run time:
+//
+//     tmm::Requantization<16> layer(W, w_quant, x_quant, y_quant, bias, true);
+//     tmm::Matrix<16,1,int8_t> y = tmm::quantizedMultiply(W, x, layer); // relu(W x + bias)
+//
+// Weights can have one scale for the whole matrix or one per row (per output
+// channel). The bias and the ReLU are applied to the int32 accumulator
+// before it is rounded.
+//
+// The int8 dot products use SIMD instructions where the target has them:
+// AVX2, SSE4.1 or SSE2 on x86, NEON on ARM application cores, and the DSP
+// extension (SMLAD, which ACLE exposes with __ARM_FEATURE_SIMD32) on
+// Cortex-M4/M7/M33. Define TMM_DISABLE_SIMD to use the plain loop everywhere.
+// The NEON and DSP paths have not been compiled yet, for lack of an ARM
+// toolchain; only the x86 and plain paths are tested.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "TMM_matrix.hpp"
+
+#ifndef TMM_DISABLE_SIMD
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define TMM_INT8_AVX2
+        #define TMM_INT8_SSE
+    #elif defined(__SSE4_1__)
+        #include <smmintrin.h>
+        #define TMM_INT8_SSE
+    #elif defined(__SSE2__) || defined(_M_X64)
+        #include <emmintrin.h>
+        #define TMM_INT8_SSE
+    #elif defined(__ARM_NEON)
+        #include <arm_neon.h>
+        #define TMM_INT8_NEON
+    #elif defined(__ARM_FEATURE_SIMD32)
+        #include <arm_acle.h>
+        #define TMM_INT8_DSP
+    #endif
+#endif
+
+
+namespace tmm{
+
+
+    /// @brief The mapping from int8 values to real numbers: real = scale * (value - zero)
+    struct Quantization{
+        float scale;
+        int32_t zero;
+    };
+
+
+    /// @brief The quantization that covers the real range [lo, hi] with all 256 values, keeping 0 exact
+    inline Quantization
+    quantizationForRange(float lo, float hi)
+    {
+        // The range must contain zero so that zero padding and ReLU outputs are exact
+        if(lo > 0) lo = 0;
+        if(hi < 0) hi = 0;
+        Quantization q;
+        q.scale = hi > lo ? (hi - lo) / 255 : 1;
+        const float zero = -128 - lo / q.scale;
+        q.zero = (int32_t)(zero < 0 ? zero - 0.5f : zero + 0.5f);
+        if(q.zero < -128) q.zero = -128;
+        if(q.zero > 127) q.zero = 127;
+        return q;
+    }
+
+
+    /// @brief Saturates a 64-bit integer to the int32 range
+    inline int32_t
+    saturateInt32(int64_t x)
+    {
+        return x > INT32_MAX ? INT32_MAX : x < INT32_MIN ? INT32_MIN : (int32_t)x;
+    }
+
+
+    /// @brief Rounds a real number to the nearest int32 (ties away from zero), saturating values out of range
+    /// @note NaN rounds to 0. Converting an out-of-range float to an integer directly is undefined.
+    inline int32_t
+    roundToInt32(float x)
+    {
+        if(x != x) return 0;
+        if(x >= 2147483648.0f) return INT32_MAX;
+        if(x <= -2147483648.0f) return INT32_MIN;
+        return (int32_t)(x < 0 ? x - 0.5f : x + 0.5f);
+    }
+
+
+    /// @brief Rounds and saturates a real number to the nearest int8 value
+    inline int8_t
+    quantizeValue(float real, Quantization q)
+    {
+        const int64_t v = (int64_t)roundToInt32(real / q.scale) + q.zero;
+        return (int8_t)(v < -128 ? -128 : v > 127 ? 127 : v);
+    }
+
+
+    /// @brief Converts a real matrix to int8 values
+    template<Size n, Size m>
+    Matrix<n,m,int8_t>
+    quantize(const Matrix<n,m,float> &X, Quantization q)
+    {
+        Matrix<n,m,int8_t> result;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < m; j++)
+        result.data[i][j] = quantizeValue(X.data[i][j], q);
+        return result;
+    }
+
+
+    /// @brief Converts int8 values back to a real matrix
+    template<Size n, Size m>
+    Matrix<n,m,float>
+    dequantize(const Matrix<n,m,int8_t> &Q, Quantization q)
+    {
+        Matrix<n,m,float> result;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < m; j++)
+        result.data[i][j] = q.scale * (float)(Q.data[i][j] - q.zero);
+        return result;
+    }
+
+
+
+    /// @brief A positive real factor as a Q31 fixed-point multiplier and a power of two:
+    /// real = multiplier * 2^(shift - 31)
+    struct FixedPointScale{
+        int32_t multiplier;
+        int shift;
+    };
+
+
+    /// @brief Finds the fixed-point form of a real factor
+    inline FixedPointScale
+    fixedPointScale(double real)
+    {
+        FixedPointScale s;
+        s.multiplier = 0;
+        s.shift = 0;
+        if(real <= 0) return s;
+
+        int exponent;
+        const double fraction = frexp(real, &exponent); // real = fraction * 2^exponent, fraction in [0.5, 1)
+        int64_t q = (int64_t)(fraction * (double)(1LL << 31) + 0.5);
+        if(q == (1LL << 31)){
+            q /= 2;
+            exponent++;
+        }
+        // Factors below 2^-31 round every accumulator to zero, and factors of 2^31 or more saturate
+        if(exponent < -31) return s;
+        if(exponent > 31){
+            q = INT32_MAX;
+            exponent = 31;
+        }
+        s.multiplier = (int32_t)q;
+        s.shift = exponent;
+        return s;
+    }
+
+
+    /// @brief Multiplies an accumulator by a fixed-point scale, rounding to nearest (ties away from zero)
+    inline int32_t
+    applyScale(int32_t x, FixedPointScale s)
+    {
+        // One 32x32 -> 64-bit multiply and one rounding shift
+        const int64_t product = (int64_t)x * s.multiplier;
+        const int right = 31 - s.shift;
+        int64_t result = product;
+        if(right > 0){
+            const int64_t half = (int64_t)1 << (right - 1);
+            result = product >= 0 ? (product + half) >> right : -((half - product) >> right);
+        }
+        return saturateInt32(result);
+    }
+
+
+
+    /// @brief The exact dot product of two int8 arrays
+    inline int32_t
+    dotInt8(const int8_t *a, const int8_t *b, int count)
+    {
+        int32_t sum = 0;
+        int k = 0;
+
+        #ifdef TMM_INT8_AVX2
+        {
+            // Widen 32 bytes to two vectors of 16 int16, then multiply and add neighboring pairs to int32
+            __m256i acc = _mm256_setzero_si256();
+            for(; k + 32 <= count; k += 32){
+                const __m256i va = _mm256_loadu_si256((const __m256i*)(a + k));
+                const __m256i vb = _mm256_loadu_si256((const __m256i*)(b + k));
+                const __m256i alo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(va));
+                const __m256i ahi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(va, 1));
+                const __m256i blo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(vb));
+                const __m256i bhi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vb, 1));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(alo, blo));
+                acc = _mm256_add_epi32(acc, _mm256_madd_epi16(ahi, bhi));
+            }
+            __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+            s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+            sum += _mm_cvtsi128_si32(s);
+        }
+        #endif
+
+        #ifdef TMM_INT8_SSE
+        {
+            __m128i acc = _mm_setzero_si128();
+            for(; k + 16 <= count; k += 16){
+                const __m128i va = _mm_loadu_si128((const __m128i*)(a + k));
+                const __m128i vb = _mm_loadu_si128((const __m128i*)(b + k));
+                #ifdef __SSE4_1__
+                const __m128i alo = _mm_cvtepi8_epi16(va);
+                const __m128i ahi = _mm_cvtepi8_epi16(_mm_srli_si128(va, 8));
+                const __m128i blo = _mm_cvtepi8_epi16(vb);
+                const __m128i bhi = _mm_cvtepi8_epi16(_mm_srli_si128(vb, 8));
+                #else
+                // Sign-extend by putting each byte in the high half of an int16 and shifting it down
+                const __m128i alo = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+                const __m128i ahi = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+                const __m128i blo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+                const __m128i bhi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+                #endif
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(alo, blo));
+                acc = _mm_add_epi32(acc, _mm_madd_epi16(ahi, bhi));
+            }
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+            acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+            sum += _mm_cvtsi128_si32(acc);
+        }
+        #endif
+
+        #ifdef TMM_INT8_NEON
+        {
+            // Products of two int8 fit in int16; add neighboring pairs of them into int32 lanes
+            int32x4_t acc = vdupq_n_s32(0);
+            for(; k + 16 <= count; k += 16){
+                const int8x16_t va = vld1q_s8(a + k);
+                const int8x16_t vb = vld1q_s8(b + k);
+                acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+                acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+            }
+            sum += vgetq_lane_s32(acc, 0) + vgetq_lane_s32(acc, 1) + vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+        }
+        #endif
+
+        #ifdef TMM_INT8_DSP
+        {
+            // Sign-extend bytes 0 and 2 (and 1 and 3) of a word to int16 pairs, then multiply-add both pairs at once
+            for(; k + 4 <= count; k += 4){
+                int32_t wa, wb;
+                memcpy(&wa, a + k, 4);
+                memcpy(&wb, b + k, 4);
+                sum = __smlad(__sxtb16(wa), __sxtb16(wb), sum);
+                sum = __smlad(__sxtb16(__ror(wa, 8)), __sxtb16(__ror(wb, 8)), sum);
+            }
+        }
+        #endif
+
+        for(; k < count; k++) sum += (int32_t)a[k] * b[k];
+        return sum;
+    }
+
+
+    /// @brief The exact product of two int8 matrices, accumulated in int32
+    template<Size n, Size m, Size q>
+    Matrix<n,q,int32_t>
+    multiplyInt32(const Matrix<n,m,int8_t> &A, const Matrix<m,q,int8_t> &B)
+    {
+        // Transpose B so that every element of the product is a dot product of two contiguous rows
+        const Matrix<q,m,int8_t> Bt = B.transpose();
+        Matrix<n,q,int32_t> C;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < q; j++)
+        C.data[i][j] = dotInt8(A.data[i], Bt.data[j], m);
+        return C;
+    }
+
+
+
+    /// @brief Everything needed to turn the int32 product of a fixed int8 matrix A (the weights) with any
+    /// int8 matrix B (the activations) into int8 outputs: zero-point corrections, bias, scale and ReLU
+    /// @tparam n the number of rows of A and of the product
+    template<Size n>
+    struct Requantization{
+        int32_t offset[n];            // added to row i: the bias and the zero-point terms that only depend on A
+        int32_t weightZero[n];        // multiplies the column sums of B
+        FixedPointScale scale[n];     // from the accumulator of row i to the output scale
+        int32_t outputZero;
+        int32_t lower, upper;         // the output is clamped to this range, which starts at outputZero with ReLU
+        bool useColumnSums;           // false if every weightZero is 0, which skips the column sums of B
+
+        /// @brief Requantization with one quantization for all of A
+        /// @param bias if not null, n real values added to the rows of the product
+        /// @param relu if true, negative outputs are set to zero
+        template<Size m>
+        Requantization(const Matrix<n,m,int8_t> &A, Quantization weights, Quantization inputs, Quantization output,
+                       const float *bias = nullptr, bool relu = false)
+        {
+            Quantization rows[n];
+            for(Size i = 0; i < n; i++) rows[i] = weights;
+            init(A, rows, inputs, output, bias, relu);
+        }
+
+        /// @brief Requantization with a quantization for each row of A (each output channel)
+        template<Size m>
+        Requantization(const Matrix<n,m,int8_t> &A, const Quantization weights[n], Quantization inputs, Quantization output,
+                       const float *bias = nullptr, bool relu = false)
+        {
+            init(A, weights, inputs, output, bias, relu);
+        }
+
+        private:
+
+        template<Size m>
+        void
+        init(const Matrix<n,m,int8_t> &A, const Quantization weights[n], Quantization inputs, Quantization output,
+             const float *bias, bool relu)
+        {
+            // sum_k (a_ik - za_i)(b_kj - zb) = sum_k a_ik b_kj - zb sum_k a_ik - za_i sum_k b_kj + m za_i zb
+            useColumnSums = false;
+            for(Size i = 0; i < n; i++){
+                int32_t row_sum = 0;
+                for(Size k = 0; k < m; k++) row_sum += A.data[i][k];
+                const float accumulator_scale = weights[i].scale * inputs.scale;
+                offset[i] = (int32_t)m * weights[i].zero * inputs.zero - inputs.zero * row_sum;
+                if(bias) offset[i] = saturateInt32((int64_t)offset[i] + roundToInt32(bias[i] / accumulator_scale));
+                weightZero[i] = weights[i].zero;
+                if(weightZero[i] != 0) useColumnSums = true;
+                scale[i] = fixedPointScale((double)accumulator_scale / output.scale);
+            }
+            outputZero = output.zero;
+            lower = relu && output.zero > -128 ? output.zero : -128;
+            upper = 127;
+        }
+    }; // end Requantization struct
+
+
+    /// @brief Multiplies int8 weights by int8 activations and requantizes the result to int8
+    /// @param A the weights that layer was made from
+    /// @param B the activations, such as one input per column
+    /// @param layer the zero points, bias, scales and ReLU of the product
+    template<Size n, Size m, Size q>
+    Matrix<n,q,int8_t>
+    quantizedMultiply(const Matrix<n,m,int8_t> &A, const Matrix<m,q,int8_t> &B, const Requantization<n> &layer)
+    {
+        const Matrix<q,m,int8_t> Bt = B.transpose();
+        int32_t column_sums[q];
+        for(Size j = 0; j < q; j++){
+            column_sums[j] = 0;
+            if(layer.useColumnSums) for(Size k = 0; k < m; k++) column_sums[j] += Bt.data[j][k];
+        }
+
+        Matrix<n,q,int8_t> C;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < q; j++){
+            // A bias that saturated the offset can push the sum past the int32 range, so add it up in 64 bits
+            const int32_t accumulator = saturateInt32((int64_t)dotInt8(A.data[i], Bt.data[j], m) + layer.offset[i]
+                                                      - (int64_t)layer.weightZero[i] * column_sums[j]);
+            int64_t v = (int64_t)applyScale(accumulator, layer.scale[i]) + layer.outputZero;
+            v = v < layer.lower ? layer.lower : v;
+            v = v > layer.upper ? layer.upper : v;
+            C.data[i][j] = (int8_t)v;
+        }
+        return C;
+    } // end quantizedMultiply
+
+}
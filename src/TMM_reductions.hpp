@@ -0,0 +1,291 @@
+// Reductions of a matrix to a single number: sums, dot products, norms, the
+// trace, and the smallest and largest elements.
+//
+// Sums run over the elements with TMM_REDUCTION_LANES independent
+// accumulators, which breaks the chain of dependent additions and lets the
+// compiler keep the lanes in one SIMD register. The order of the additions
+// only depends on the matrix size, so the result is the same on every run.
+// For sums that must lose less precision, pass Summation::Kahan (compensated)
+// or Summation::Pairwise. Compensated summation relies on exact
+// floating-point rounding, so it doesn't work with -ffast-math.
+
+#pragma once
+
+#include <math.h>
+#include "TMM_matrix.hpp"
+
+// The number of independent accumulators in a sum, a power of two. Boards without an FPU or SIMD gain nothing from more than one.
+#ifndef TMM_REDUCTION_LANES
+    #ifdef __AVR__
+        #define TMM_REDUCTION_LANES 1
+    #else
+        #define TMM_REDUCTION_LANES 8
+    #endif
+#endif
+static_assert(TMM_REDUCTION_LANES > 0 && (TMM_REDUCTION_LANES & (TMM_REDUCTION_LANES - 1)) == 0,
+    "TMM_REDUCTION_LANES must be a power of two, since the lanes are combined by halving");
+
+// Pairwise summation adds blocks of at most this many terms directly
+#ifndef TMM_PAIRWISE_BLOCK
+    #define TMM_PAIRWISE_BLOCK 128
+#endif
+
+
+namespace tmm{
+
+
+    enum class Summation : unsigned char {
+        Lanes,    // TMM_REDUCTION_LANES interleaved partial sums: the fastest
+        Kahan,    // compensated summation: error independent of the number of terms, at a few times the cost
+        Pairwise  // recursive halving: error grows with log(count), at about the speed of Lanes
+    };
+
+
+    // Sums term(0) + ... + term(count-1) with interleaved accumulators
+    template<typename Scalar, typename Term>
+    Scalar
+    sumLanes(int count, Term term)
+    {
+        Scalar lanes[TMM_REDUCTION_LANES];
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++) lanes[l] = 0;
+        int k = 0;
+        for(; k + TMM_REDUCTION_LANES <= count; k += TMM_REDUCTION_LANES)
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++)
+        lanes[l] += term(k + l);
+        for(int l = 0; l < TMM_REDUCTION_LANES && k + l < count; l++) lanes[l] += term(k + l);
+
+        // Combine the lanes pairwise, which also keeps the result independent of the remainder
+        for(int width = TMM_REDUCTION_LANES / 2; width > 0; width /= 2)
+        for(int l = 0; l < width; l++)
+        lanes[l] += lanes[l + width];
+        return lanes[0];
+    }
+
+
+    // Adds x to sum, keeping the low-order bits that are lost in compensation. This branches,
+    // but holds up when x is larger than sum (Neumaier's improvement to Kahan).
+    template<typename Scalar>
+    void
+    addCompensated(Scalar &sum, Scalar &compensation, Scalar x)
+    {
+        const Scalar t = sum + x;
+        if((sum < 0 ? -sum : sum) >= (x < 0 ? -x : x)) compensation += (sum - t) + x;
+        else compensation += (x - t) + sum;
+        sum = t;
+    }
+
+
+    // Kahan summation in each lane, then the lanes and their corrections are added with addCompensated
+    template<typename Scalar, typename Term>
+    Scalar
+    sumKahan(int count, Term term)
+    {
+        Scalar lanes[TMM_REDUCTION_LANES], corrections[TMM_REDUCTION_LANES];
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++) lanes[l] = corrections[l] = 0;
+        auto add = [&](int l, Scalar x){
+            const Scalar y = x - corrections[l];
+            const Scalar t = lanes[l] + y;
+            corrections[l] = (t - lanes[l]) - y;
+            lanes[l] = t;
+        };
+        int k = 0;
+        for(; k + TMM_REDUCTION_LANES <= count; k += TMM_REDUCTION_LANES)
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++)
+        add(l, term(k + l));
+        for(int l = 0; l < TMM_REDUCTION_LANES && k + l < count; l++) add(l, term(k + l));
+
+        Scalar sum = 0, compensation = 0;
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++){
+            addCompensated(sum, compensation, lanes[l]);
+            addCompensated(sum, compensation, -corrections[l]);
+        }
+        return sum + compensation;
+    }
+
+
+    template<typename Scalar, typename Term>
+    Scalar
+    sumPairwise(int first, int count, Term term)
+    {
+        if(count <= TMM_PAIRWISE_BLOCK){
+            return sumLanes<Scalar>(count, [&](int k){ return term(first + k); });
+        }
+        const int half = count / 2;
+        return sumPairwise<Scalar>(first, half, term) + sumPairwise<Scalar>(first + half, count - half, term);
+    }
+
+
+    /// @brief Sums term(0) + ... + term(count-1)
+    /// @param term a function that returns the k-th term
+    template<typename Scalar, typename Term>
+    Scalar
+    sumTerms(int count, Term term, Summation summation = Summation::Lanes)
+    {
+        switch(summation){
+            case Summation::Kahan:    return sumKahan<Scalar>(count, term);
+            case Summation::Pairwise: return sumPairwise<Scalar>(0, count, term);
+            default:                  return sumLanes<Scalar>(count, term);
+        }
+    }
+
+
+
+    /// @brief Returns the sum of all elements of a matrix
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    sum(const Matrix<n,m,Scalar> &A, Summation summation = Summation::Lanes)
+    {
+        const Scalar *a = &A.data[0][0];
+        return sumTerms<Scalar>(n*m, [a](int k){ return a[k]; }, summation);
+    }
+
+
+    /// @brief Returns the sum of the products of corresponding elements: u^T v for column vectors u and v
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    dot(const Matrix<n,m,Scalar> &A, const Matrix<n,m,Scalar> &B, Summation summation = Summation::Lanes)
+    {
+        const Scalar *a = &A.data[0][0];
+        const Scalar *b = &B.data[0][0];
+        return sumTerms<Scalar>(n*m, [a,b](int k){ return a[k] * b[k]; }, summation);
+    }
+
+
+    /// @brief Returns the sum of the squares of all elements
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    squaredNorm(const Matrix<n,m,Scalar> &A, Summation summation = Summation::Lanes)
+    {
+        return dot(A, A, summation);
+    }
+
+
+    /// @brief Returns the Frobenius norm, the square root of the sum of squares. For vectors, this is the Euclidean length.
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    frobeniusNorm(const Matrix<n,m,Scalar> &A, Summation summation = Summation::Lanes)
+    {
+        return sqrt(squaredNorm(A, summation));
+    }
+
+
+    /// @brief Returns the sum of the diagonal elements of a square matrix
+    template<Size n, typename Scalar>
+    Scalar
+    trace(const Matrix<n,n,Scalar> &A, Summation summation = Summation::Lanes)
+    {
+        const Scalar *a = &A.data[0][0];
+        return sumTerms<Scalar>(n, [a](int k){ return a[k*(n+1)]; }, summation);
+    }
+
+
+    /// @brief Returns the 1-norm (largest absolute column sum) of a matrix
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    oneNorm(const Matrix<n,m,Scalar> &A)
+    {
+        // Accumulate all column sums a row at a time, reading A in order
+        Scalar columns[m > 0 ? m : 1];
+        for(Size j = 0; j < m; j++) columns[j] = 0;
+        for(Size i = 0; i < n; i++)
+        for(Size j = 0; j < m; j++)
+        columns[j] += A.data[i][j] < 0 ? -A.data[i][j] : A.data[i][j];
+
+        Scalar largest = 0;
+        for(Size j = 0; j < m; j++) if(columns[j] > largest) largest = columns[j];
+        return largest;
+    }
+
+
+    /// @brief Returns the infinity-norm (largest absolute row sum) of a matrix
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    infinityNorm(const Matrix<n,m,Scalar> &A)
+    {
+        Scalar largest = 0;
+        for(Size i = 0; i < n; i++){
+            const Scalar *row = A.data[i];
+            const Scalar s = sumLanes<Scalar>(m, [row](int k){ return row[k] < 0 ? -row[k] : row[k]; });
+            if(s > largest) largest = s;
+        }
+        return largest;
+    }
+
+
+    /// @brief Returns the largest absolute value of any element (the max norm)
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    maxAbs(const Matrix<n,m,Scalar> &A)
+    {
+        const Scalar *a = &A.data[0][0];
+        Scalar lanes[TMM_REDUCTION_LANES];
+        for(int l = 0; l < TMM_REDUCTION_LANES; l++) lanes[l] = 0;
+        for(int k = 0; k < n*m; k++){
+            const Scalar x = a[k] < 0 ? -a[k] : a[k];
+            Scalar &lane = lanes[k % TMM_REDUCTION_LANES];
+            lane = x > lane ? x : lane;
+        }
+        Scalar largest = lanes[0];
+        for(int l = 1; l < TMM_REDUCTION_LANES; l++) if(lanes[l] > largest) largest = lanes[l];
+        return largest;
+    }
+
+
+    /// @brief Returns the largest element
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    maxElement(const Matrix<n,m,Scalar> &A)
+    {
+        const Scalar *a = &A.data[0][0];
+        Scalar largest = a[0];
+        for(int k = 1; k < n*m; k++) largest = a[k] > largest ? a[k] : largest;
+        return largest;
+    }
+
+
+    /// @brief Returns the smallest element
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    minElement(const Matrix<n,m,Scalar> &A)
+    {
+        const Scalar *a = &A.data[0][0];
+        Scalar smallest = a[0];
+        for(int k = 1; k < n*m; k++) smallest = a[k] < smallest ? a[k] : smallest;
+        return smallest;
+    }
+
+
+    /// @brief Finds the largest element
+    /// @param row on return, the row of the largest element (the first one, if there are ties)
+    /// @param col on return, the column of the largest element
+    /// @return the largest element
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    argmax(const Matrix<n,m,Scalar> &A, Size &row, Size &col)
+    {
+        const Scalar *a = &A.data[0][0];
+        int best = 0;
+        for(int k = 1; k < n*m; k++) if(a[k] > a[best]) best = k;
+        row = (Size)(best / m);
+        col = (Size)(best % m);
+        return a[best];
+    }
+
+
+    /// @brief Finds the smallest element
+    /// @param row on return, the row of the smallest element (the first one, if there are ties)
+    /// @param col on return, the column of the smallest element
+    /// @return the smallest element
+    template<Size n, Size m, typename Scalar>
+    Scalar
+    argmin(const Matrix<n,m,Scalar> &A, Size &row, Size &col)
+    {
+        const Scalar *a = &A.data[0][0];
+        int best = 0;
+        for(int k = 1; k < n*m; k++) if(a[k] < a[best]) best = k;
+        row = (Size)(best / m);
+        col = (Size)(best % m);
+        return a[best];
+    }
+
+}
@@ -0,0 +1,78 @@
+// Fused symmetric "sandwich" products A*P*A^T, as used in covariance propagation.
+//
+// Writing F * P * F.transpose() + Q copies F, builds two full product
+// temporaries and computes both halves of a symmetric result. These functions
+// read A in place, keep only one row of A*P at a time, compute the upper
+// triangle, and mirror it so the result is exactly symmetric.
+
+#pragma once
+
+#include "TMM_matrix.hpp"
+
+
+namespace tmm{
+
+
+    /// @brief Adds A*P*A^T to a symmetric output matrix (M += A*P*A^T)
+    /// @param A an n x m matrix
+    /// @param P a symmetric m x m matrix
+    /// @param M the matrix to accumulate into. Only its upper triangle is read;
+    /// on return its lower triangle is a mirror of the upper triangle.
+    /// M may be P or A, as in sandwichAccumulate(F, P, P) for P += F*P*F^T,
+    /// in which case the sum is built in a temporary and copied back.
+    template<Size n, Size m, typename Scalar>
+    void
+    sandwichAccumulate(const Matrix<n,m,Scalar> &A, const Matrix<m,m,Scalar> &P, Matrix<n,n,Scalar> &M)
+    {
+        // Rows of M are written while A and P are still being read
+        if((const void*)&M == (const void*)&P || (const void*)&M == (const void*)&A){
+            Matrix<n,n,Scalar> sum = M;
+            sandwichAccumulate(A, P, sum);
+            M = sum;
+            return;
+        }
+
+        Scalar row[m > 0 ? m : 1]; // one row of A*P
+        for(Size i = 0; i < n; i++){
+            for(Size k = 0; k < m; k++) row[k] = 0;
+            for(Size l = 0; l < m; l++){
+                const Scalar a = A.data[i][l];
+                for(Size k = 0; k < m; k++) row[k] += a * P.data[l][k];
+            }
+            for(Size j = i; j < n; j++){
+                Scalar s = 0;
+                for(Size k = 0; k < m; k++) s += row[k] * A.data[j][k];
+                M.data[i][j] += s;
+                M.data[j][i] = M.data[i][j];
+            }
+        }
+    } // end sandwichAccumulate
+
+
+    /// @brief Returns A*P*A^T for a symmetric P, with an exactly symmetric result
+    /// @param A an n x m matrix
+    /// @param P a symmetric m x m matrix
+    template<Size n, Size m, typename Scalar>
+    Matrix<n,n,Scalar>
+    sandwich(const Matrix<n,m,Scalar> &A, const Matrix<m,m,Scalar> &P)
+    {
+        Matrix<n,n,Scalar> M;
+        sandwichAccumulate(A, P, M);
+        return M;
+    }
+
+
+    /// @brief Returns A*P*A^T + Q for symmetric P and Q, with an exactly symmetric result
+    /// @param A an n x m matrix
+    /// @param P a symmetric m x m matrix
+    /// @param Q a symmetric n x n matrix. Only its upper triangle is read.
+    template<Size n, Size m, typename Scalar>
+    Matrix<n,n,Scalar>
+    sandwich(const Matrix<n,m,Scalar> &A, const Matrix<m,m,Scalar> &P, const Matrix<n,n,Scalar> &Q)
+    {
+        Matrix<n,n,Scalar> M = Q;
+        sandwichAccumulate(A, P, M);
+        return M;
+    }
+
+}
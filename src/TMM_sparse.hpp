@@ -0,0 +1,620 @@
+// Matrices with a sparsity pattern that is fixed at compile time.
+//
+// Block-diagonal models and measurement Jacobians have the same zeros on
+// every update. A SparseStaticMatrix stores only the elements its pattern
+// marks as nonzero, and its products are unrolled at compile time into one
+// multiply-add per pair of nonzero terms, so structural zeros cost neither
+// memory nor time. The pattern of a product of two sparse matrices is
+// worked out at compile time too.
+//
+// A SparsityPattern<n,m> is a bitmask over an n x m matrix in row-major
+// order, kept in 64-bit words: bit k of word w is set if element number
+// 64*w + k, which is (i,j) with i*m + j = 64*w + k, may be nonzero.
+// blockPattern() and diagonalPattern() build patterns, which can be combined
+// with |. A matrix refers to its pattern, so declare the pattern constexpr
+// outside any function:
+//
+//     // Two 3x3 blocks on the diagonal of a 6x6 matrix
+//     constexpr tmm::SparsityPattern<6,6> blocks = tmm::blockPattern<6,6>(0, 0, 3, 3) | tmm::blockPattern<6,6>(3, 3, 3, 3);
+//     tmm::SparseStaticMatrix<6,6,blocks> F(dense_F);
+//     tmm::Matrix<6,1> x2 = F * x;  // 18 multiply-adds instead of 36
+//
+// Matrices with equal patterns declared separately are different types;
+// convert between them through dense().
+//
+// Patterns and products are unrolled a 64-bit word at a time, so matrices of
+// any size up to 255 x 255 compile without deep template recursion, and
+// compile time grows with the number of nonzeros.
+
+#pragma once
+
+#include "TMM_matrix.hpp"
+
+
+namespace tmm{
+
+
+    // The word numbers 0..count-1 of a pattern, as a pack to initialize or visit its words with.
+    // The two halves are built separately, so a pattern of any size only takes log2(count) levels of templates.
+    template<int... w> struct PatternWords{};
+
+    template<typename First, typename Second> struct JoinPatternWords;
+    template<int... a, int... b>
+    struct JoinPatternWords<PatternWords<a...>, PatternWords<b...>>{
+        typedef PatternWords<a..., (int)sizeof...(a) + b...> type;
+    };
+
+    template<int count>
+    struct MakePatternWords{
+        typedef typename JoinPatternWords<typename MakePatternWords<count / 2>::type,
+                                          typename MakePatternWords<count - count / 2>::type>::type type;
+    };
+    template<> struct MakePatternWords<0>{ typedef PatternWords<> type; };
+    template<> struct MakePatternWords<1>{ typedef PatternWords<0> type; };
+
+
+    // Word w of a pattern over count elements, with bit b set where bits(64*w + b) is true
+    template<typename Bits>
+    constexpr unsigned long long
+    patternWord(const Bits &bits, int count, int w, int b = 0)
+    {
+        return b == 64 || 64*w + b >= count ? 0
+            : (bits(64*w + b) ? 1ull << b : 0) | patternWord(bits, count, w, b+1);
+    }
+
+
+    /// @brief Which elements of an n x m matrix may be nonzero, as a bitmask in row-major order
+    template<Size n, Size m>
+    struct SparsityPattern{
+        static const int words = n*m > 0 ? (n*m + 63) / 64 : 1;
+
+        /// @brief Bit k of word w is element number 64*w + k
+        unsigned long long word[words];
+
+        /// @brief A pattern with no nonzero elements
+        constexpr SparsityPattern() : word{} {}
+
+        /// @brief Sets element number bit where bits(bit) is true. blockPattern() and the like call this.
+        template<typename Bits, int... w>
+        constexpr SparsityPattern(const Bits &bits, PatternWords<w...>) : word{ patternWord(bits, n*m, w)... } {}
+
+        /// @brief True if the pattern marks element number bit (in row-major order) as nonzero
+        constexpr bool
+        has(int bit) const
+        {
+            return (word[bit / 64] >> (bit % 64)) & 1u;
+        }
+    };
+
+    template<Size n, Size m> const int SparsityPattern<n,m>::words;
+
+
+    /// @brief The pattern of an n x m matrix with element number bit set where bits(bit) is true
+    template<Size n, Size m, typename Bits>
+    constexpr SparsityPattern<n,m>
+    makePattern(const Bits &bits)
+    {
+        return SparsityPattern<n,m>(bits, typename MakePatternWords<SparsityPattern<n,m>::words>::type());
+    }
+
+
+    /// @brief True if the pattern marks element number bit (in row-major order) as nonzero
+    template<Size n, Size m>
+    constexpr bool
+    patternHas(const SparsityPattern<n,m> &pattern, int bit)
+    {
+        return pattern.has(bit);
+    }
+
+
+    // The number of set bits in a word, adding up neighbouring bits, then pairs, then nibbles, then bytes
+    constexpr int popcountBytes(unsigned long long x){ return (int)((x * 0x0101010101010101ull) >> 56); }
+    constexpr int popcountNibbles(unsigned long long x){ return popcountBytes((x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full); }
+    constexpr int popcountPairs(unsigned long long x){ return popcountNibbles((x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull)); }
+    constexpr int popcountWord(unsigned long long x){ return popcountPairs(x - ((x >> 1) & 0x5555555555555555ull)); }
+
+    // The position of the lowest set bit of a nonzero word: the number of zeros below it
+    constexpr int lowestBit(unsigned long long x){ return popcountWord((x & (0 - x)) - 1); }
+
+    // A word with the lowest count bits set
+    constexpr unsigned long long lowBits(int count){ return count >= 64 ? ~0ull : (1ull << count) - 1; }
+
+    // The 64 bits of a pattern from element number start on, which must be inside the matrix (zeros past its end)
+    template<Size n, Size m>
+    constexpr unsigned long long
+    patternBits(const SparsityPattern<n,m> &pattern, int start)
+    {
+        return start % 64 == 0 ? pattern.word[start / 64]
+            : (pattern.word[start / 64] >> (start % 64))
+              | (start / 64 + 1 < SparsityPattern<n,m>::words ? pattern.word[start / 64 + 1] << (64 - start % 64) : 0);
+    }
+
+    // The number of set bits in words first..last-1, halving the range so the recursion stays shallow
+    template<Size n, Size m>
+    constexpr int
+    patternWordsCount(const SparsityPattern<n,m> &pattern, int first, int last)
+    {
+        return last - first == 0 ? 0
+            : last - first == 1 ? popcountWord(pattern.word[first])
+            : patternWordsCount(pattern, first, (first + last) / 2) + patternWordsCount(pattern, (first + last) / 2, last);
+    }
+
+    /// @brief The number of nonzero elements in a pattern
+    template<Size n, Size m>
+    constexpr int
+    patternCount(const SparsityPattern<n,m> &pattern)
+    {
+        return patternWordsCount(pattern, 0, SparsityPattern<n,m>::words);
+    }
+
+    /// @brief Where element number bit (in row-major order) is stored: the number of nonzeros before it
+    template<Size n, Size m>
+    constexpr int
+    patternIndex(const SparsityPattern<n,m> &pattern, int bit)
+    {
+        return patternWordsCount(pattern, 0, bit / 64) + popcountWord(pattern.word[bit / 64] & ((1ull << (bit % 64)) - 1));
+    }
+
+
+    // True if words first..last-1 of both patterns are the same
+    template<Size n, Size m>
+    constexpr bool
+    patternWordsEqual(const SparsityPattern<n,m> &a, const SparsityPattern<n,m> &b, int first, int last)
+    {
+        return last - first == 0 ? true
+            : last - first == 1 ? a.word[first] == b.word[first]
+            : patternWordsEqual(a, b, first, (first + last) / 2) && patternWordsEqual(a, b, (first + last) / 2, last);
+    }
+
+    template<Size n, Size m>
+    constexpr bool
+    operator ==(const SparsityPattern<n,m> &a, const SparsityPattern<n,m> &b)
+    {
+        return patternWordsEqual(a, b, 0, SparsityPattern<n,m>::words);
+    }
+
+
+    // The elements that patterns are built from, for makePattern()
+    struct BlockBits{
+        int cols, row, col, rows, width;
+        constexpr bool operator ()(int bit) const {
+            return bit / cols >= row && bit / cols < row + rows && bit % cols >= col && bit % cols < col + width;
+        }
+    };
+
+    struct DiagonalBits{
+        int cols;
+        constexpr bool operator ()(int bit) const { return bit / cols == bit % cols; }
+    };
+
+    template<Size n, Size m>
+    struct UnionBits{
+        const SparsityPattern<n,m> &a, &b;
+        constexpr bool operator ()(int bit) const { return a.has(bit) || b.has(bit); }
+    };
+
+    // Element (i,j) of the m x n transpose is element (j,i) of the pattern
+    template<Size n, Size m>
+    struct TransposeBits{
+        const SparsityPattern<n,m> &pattern;
+        constexpr bool operator ()(int bit) const { return pattern.has((bit % n)*m + bit / n); }
+    };
+
+    // The product of an n x m pattern a and an m x q pattern b, which makePattern() builds a word at a time
+    template<Size n, Size m, Size q>
+    struct ProductBits{
+        const SparsityPattern<n,m> &a;
+        const SparsityPattern<m,q> &b;
+    };
+
+    // The nonzeros of row i of a in columns column..column+63
+    template<Size n, Size m>
+    constexpr unsigned long long
+    rowChunk(const SparsityPattern<n,m> &a, int i, int column)
+    {
+        return patternBits(a, i*m + column) & lowBits(m - column);
+    }
+
+    // The part of row k of b that lands in word w of the product, in row i
+    template<Size m, Size q>
+    constexpr unsigned long long
+    productPiece(const SparsityPattern<m,q> &b, int k, int i, int first, int end)
+    {
+        return (patternBits(b, k*q + first - i*q) & lowBits(end - first)) << (first % 64);
+    }
+
+    // Row i of the product within word w is the union of the rows k of b where a(i,k) is nonzero.
+    // Visits those k, where nonzeros holds the ones in columns column..column+63 not visited yet.
+    template<Size n, Size m, Size q>
+    constexpr unsigned long long
+    productRow(const ProductBits<n,m,q> &bits, int i, int w, int column, unsigned long long nonzeros)
+    {
+        return nonzeros != 0
+            ? productPiece(bits.b, column + lowestBit(nonzeros), i, 64*w > i*q ? 64*w : i*q, 64*w + 64 < (i+1)*q ? 64*w + 64 : (i+1)*q)
+              | productRow(bits, i, w, column, nonzeros & (nonzeros - 1))
+            : column + 64 < m ? productRow(bits, i, w, column + 64, rowChunk(bits.a, i, column + 64))
+            : 0;
+    }
+
+    // Word w of the product, from row i on. This only visits the nonzeros of a, instead of every (i,j,k).
+    template<Size n, Size m, Size q>
+    constexpr unsigned long long
+    productWord(const ProductBits<n,m,q> &bits, int w, int i)
+    {
+        return i >= n || i*q >= 64*w + 64 ? 0
+            : (m > 0 ? productRow(bits, i, w, 0, rowChunk(bits.a, i, 0)) : 0) | productWord(bits, w, i+1);
+    }
+
+    template<Size n, Size m, Size q>
+    constexpr unsigned long long
+    patternWord(const ProductBits<n,m,q> &bits, int, int w, int = 0)
+    {
+        return q == 0 ? 0 : productWord(bits, w, 64*w / (q > 0 ? q : 1));
+    }
+
+
+    /// @brief The pattern of a block of ones in an n x m matrix
+    /// @param row the first row of the block
+    /// @param col the first column of the block
+    /// @param rows the number of rows in the block
+    /// @param width the number of columns in the block
+    template<Size n, Size m>
+    constexpr SparsityPattern<n,m>
+    blockPattern(int row, int col, int rows, int width)
+    {
+        return makePattern<n,m>(BlockBits{m, row, col, rows, width});
+    }
+
+    /// @brief The pattern of the main diagonal of an n x m matrix
+    template<Size n, Size m>
+    constexpr SparsityPattern<n,m>
+    diagonalPattern()
+    {
+        return makePattern<n,m>(DiagonalBits{m});
+    }
+
+    /// @brief The elements that are nonzero in either pattern
+    template<Size n, Size m>
+    constexpr SparsityPattern<n,m>
+    operator |(const SparsityPattern<n,m> &a, const SparsityPattern<n,m> &b)
+    {
+        return makePattern<n,m>(UnionBits<n,m>{a, b});
+    }
+
+    /// @brief The pattern of the transpose of an n x m matrix
+    template<Size n, Size m>
+    constexpr SparsityPattern<m,n>
+    transposePattern(const SparsityPattern<n,m> &pattern)
+    {
+        return makePattern<m,n>(TransposeBits<n,m>{pattern});
+    }
+
+    /// @brief The pattern of the product of an n x m pattern a and an m x q pattern b
+    template<Size n, Size m, Size q>
+    constexpr SparsityPattern<n,q>
+    productPattern(const SparsityPattern<n,m> &a, const SparsityPattern<m,q> &b)
+    {
+        return makePattern<n,q>(ProductBits<n,m,q>{a, b});
+    }
+
+
+    // The patterns of transposes and products, as objects that a SparseStaticMatrix can refer to
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern>
+    struct TransposedPattern{
+        static constexpr SparsityPattern<m,n> value = transposePattern(Pattern);
+    };
+
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B>
+    struct ProductOfPatterns{
+        static constexpr SparsityPattern<n,q> value = productPattern(A, B);
+    };
+
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern>
+    constexpr SparsityPattern<m,n> TransposedPattern<n,m,Pattern>::value;
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B>
+    constexpr SparsityPattern<n,q> ProductOfPatterns<n,m,q,A,B>::value;
+
+
+
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, typename Scalar = float>
+    class SparseStaticMatrix;
+
+
+    // Visits the nonzeros of word w of an n x m pattern, lowest first, where remaining holds the ones not visited yet.
+    // Each visit is its own inlined function, and zeros aren't visited at all, so only nonzeros generate code.
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, int w, unsigned long long remaining = Pattern.word[w]>
+    struct SparseWordTerms{
+        static const int bit = 64*w + lowestBit(remaining);
+        static const int i = bit / m, j = bit % m;
+        static const int index = patternIndex(Pattern, bit);
+        static const int transposedIndex = patternIndex(TransposedPattern<n,m,Pattern>::value, j*n + i);
+        typedef SparseWordTerms<n, m, Pattern, w, remaining & (remaining - 1)> Next;
+
+        template<typename Scalar>
+        static void
+        gather(Scalar *values, const Matrix<n,m,Scalar> &M)
+        {
+            values[index] = M.data[i][j];
+            Next::gather(values, M);
+        }
+
+        template<typename Scalar>
+        static void
+        scatter(const Scalar *values, Matrix<n,m,Scalar> &M)
+        {
+            M.data[i][j] = values[index];
+            Next::scatter(values, M);
+        }
+
+        // R += A * B, where A has this pattern: row i of R gets A(i,j) times row j of B
+        template<Size q, typename Scalar>
+        static void
+        leftMultiply(const Scalar *values, const Matrix<m,q,Scalar> &B, Matrix<n,q,Scalar> &R)
+        {
+            for(Size c = 0; c < q; c++) R.data[i][c] += values[index] * B.data[j][c];
+            Next::leftMultiply(values, B, R);
+        }
+
+        // R += B * A, where A has this pattern: column j of R gets column i of B times A(i,j)
+        template<Size p, typename Scalar>
+        static void
+        rightMultiply(const Matrix<p,n,Scalar> &B, const Scalar *values, Matrix<p,m,Scalar> &R)
+        {
+            for(Size r = 0; r < p; r++) R.data[r][j] += B.data[r][i] * values[index];
+            Next::rightMultiply(B, values, R);
+        }
+
+        // Moves each nonzero to its place in the transpose
+        template<typename Scalar>
+        static void
+        transpose(const Scalar *values, Scalar *transposed)
+        {
+            transposed[transposedIndex] = values[index];
+            Next::transpose(values, transposed);
+        }
+    };
+
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, int w>
+    struct SparseWordTerms<n, m, Pattern, w, 0>{
+        template<typename Scalar> static void gather(Scalar*, const Matrix<n,m,Scalar>&) {}
+        template<typename Scalar> static void scatter(const Scalar*, Matrix<n,m,Scalar>&) {}
+        template<Size q, typename Scalar> static void leftMultiply(const Scalar*, const Matrix<m,q,Scalar>&, Matrix<n,q,Scalar>&) {}
+        template<Size p, typename Scalar> static void rightMultiply(const Matrix<p,n,Scalar>&, const Scalar*, Matrix<p,m,Scalar>&) {}
+        template<typename Scalar> static void transpose(const Scalar*, Scalar*) {}
+    };
+
+
+    // Visits every nonzero of an n x m pattern in row-major order, expanding over its words, so the
+    // templates nest at most 64 levels deep (one per bit of a word) whatever the size of the matrix.
+    // The braced lists only sequence the calls from the first word to the last.
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern,
+             typename Words = typename MakePatternWords<SparsityPattern<n,m>::words>::type>
+    struct SparseTerms;
+
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, int... w>
+    struct SparseTerms<n, m, Pattern, PatternWords<w...>>{
+        template<typename Scalar>
+        static void
+        gather(Scalar *values, const Matrix<n,m,Scalar> &M)
+        {
+            const int visit[] = {0, (SparseWordTerms<n,m,Pattern,w>::gather(values, M), 0)...};
+            (void)visit;
+        }
+
+        template<typename Scalar>
+        static void
+        scatter(const Scalar *values, Matrix<n,m,Scalar> &M)
+        {
+            const int visit[] = {0, (SparseWordTerms<n,m,Pattern,w>::scatter(values, M), 0)...};
+            (void)visit;
+        }
+
+        template<Size q, typename Scalar>
+        static void
+        leftMultiply(const Scalar *values, const Matrix<m,q,Scalar> &B, Matrix<n,q,Scalar> &R)
+        {
+            const int visit[] = {0, (SparseWordTerms<n,m,Pattern,w>::leftMultiply(values, B, R), 0)...};
+            (void)visit;
+        }
+
+        template<Size p, typename Scalar>
+        static void
+        rightMultiply(const Matrix<p,n,Scalar> &B, const Scalar *values, Matrix<p,m,Scalar> &R)
+        {
+            const int visit[] = {0, (SparseWordTerms<n,m,Pattern,w>::rightMultiply(B, values, R), 0)...};
+            (void)visit;
+        }
+
+        template<typename Scalar>
+        static void
+        transpose(const Scalar *values, Scalar *transposed)
+        {
+            const int visit[] = {0, (SparseWordTerms<n,m,Pattern,w>::transpose(values, transposed), 0)...};
+            (void)visit;
+        }
+    };
+
+
+    // Visits the products of the nonzero a(i,k) with each nonzero b(k,c) in row k of an m x q pattern B,
+    // adding them to element (i,c) of an n x q result with pattern C. The row is visited 64 columns at
+    // a time, from column on, and remaining holds the nonzeros of those columns not visited yet.
+    template<Size n, Size m, Size q, const SparsityPattern<m,q> &B, const SparsityPattern<n,q> &C, int i, int k,
+             int column = 0, bool done = (column >= q), unsigned long long remaining = done ? 0 : patternBits(B, k*q + column) & lowBits(q - column)>
+    struct SparseRowProduct{
+        static const int c = column + lowestBit(remaining);
+        static const int index = patternIndex(B, k*q + c);        // of b(k,c)
+        static const int resultIndex = patternIndex(C, i*q + c);  // of the result (i,c)
+        typedef SparseRowProduct<n, m, q, B, C, i, k, column, false, remaining & (remaining - 1)> Next;
+
+        template<typename Scalar>
+        static void
+        apply(Scalar a, const Scalar *b, Scalar *result)
+        {
+            result[resultIndex] += a * b[index];
+            Next::apply(a, b, result);
+        }
+    };
+
+    // These 64 columns are done: go on to the next ones
+    template<Size n, Size m, Size q, const SparsityPattern<m,q> &B, const SparsityPattern<n,q> &C, int i, int k, int column>
+    struct SparseRowProduct<n, m, q, B, C, i, k, column, false, 0>{
+        template<typename Scalar>
+        static void
+        apply(Scalar a, const Scalar *b, Scalar *result)
+        {
+            SparseRowProduct<n, m, q, B, C, i, k, column + 64>::apply(a, b, result);
+        }
+    };
+
+    template<Size n, Size m, Size q, const SparsityPattern<m,q> &B, const SparsityPattern<n,q> &C, int i, int k, int column>
+    struct SparseRowProduct<n, m, q, B, C, i, k, column, true, 0>{
+        template<typename Scalar> static void apply(Scalar, const Scalar*, Scalar*) {}
+    };
+
+
+    // Visits every nonzero a(i,k) in word w of an n x m pattern A, for the product with an m x q pattern B
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B, int w,
+             unsigned long long remaining = A.word[w]>
+    struct SparseWordProduct{
+        static const int bit = 64*w + lowestBit(remaining);
+        static const int index = patternIndex(A, bit);
+        typedef SparseRowProduct<n, m, q, B, ProductOfPatterns<n,m,q,A,B>::value, bit / m, bit % m> Row;
+        typedef SparseWordProduct<n, m, q, A, B, w, remaining & (remaining - 1)> Next;
+
+        template<typename Scalar>
+        static void
+        apply(const Scalar *a, const Scalar *b, Scalar *result)
+        {
+            Row::apply(a[index], b, result);
+            Next::apply(a, b, result);
+        }
+    };
+
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B, int w>
+    struct SparseWordProduct<n, m, q, A, B, w, 0>{
+        template<typename Scalar> static void apply(const Scalar*, const Scalar*, Scalar*) {}
+    };
+
+
+    // Visits every nonzero a(i,k) of A, word by word as SparseTerms does
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B,
+             typename Words = typename MakePatternWords<SparsityPattern<n,m>::words>::type>
+    struct SparseProduct;
+
+    template<Size n, Size m, Size q, const SparsityPattern<n,m> &A, const SparsityPattern<m,q> &B, int... w>
+    struct SparseProduct<n, m, q, A, B, PatternWords<w...>>{
+        template<typename Scalar>
+        static void
+        apply(const Scalar *a, const Scalar *b, Scalar *result)
+        {
+            const int visit[] = {0, (SparseWordProduct<n,m,q,A,B,w>::apply(a, b, result), 0)...};
+            (void)visit;
+        }
+    };
+
+
+
+    /// @brief An n x m matrix that stores only the elements its compile-time pattern marks as nonzero
+    /// @tparam Pattern a constexpr pattern of the nonzero elements, such as blockPattern<n,m>(...) | diagonalPattern<n,m>()
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, typename Scalar>
+    class SparseStaticMatrix{
+        public:
+
+        /// @brief The number of stored elements
+        static const int count = patternCount(Pattern);
+
+        /// @brief The nonzero elements, in row-major order
+        Scalar values[count > 0 ? count : 1];
+
+        SparseStaticMatrix(){
+            for(int k = 0; k < count; k++) values[k] = 0;
+        }
+
+        /// @brief Copies the elements of a dense matrix that are in the pattern. The others are ignored.
+        explicit SparseStaticMatrix(const Matrix<n,m,Scalar> &M){
+            SparseTerms<n,m,Pattern>::gather(values, M);
+        }
+
+        /// @brief True if the pattern marks element (i,j) as nonzero
+        static constexpr bool
+        isNonzero(Size i, Size j)
+        {
+            return Pattern.has(i*m + j);
+        }
+
+        /// @brief Element (i,j), which must be in the pattern
+        template<Size i, Size j>
+        Scalar&
+        at()
+        {
+            static_assert(i < n && j < m && Pattern.has(i*m + j), "This element is always zero");
+            return values[patternIndex(Pattern, i*m + j)];
+        }
+
+        /// @brief Element (i,j), or zero if it isn't in the pattern
+        Scalar
+        get(Size i, Size j) const
+        {
+            return isNonzero(i, j) ? values[patternIndex(Pattern, i*m + j)] : Scalar(0);
+        }
+
+        Matrix<n,m,Scalar>
+        dense() const
+        {
+            Matrix<n,m,Scalar> M;
+            SparseTerms<n,m,Pattern>::scatter(values, M);
+            return M;
+        }
+
+        SparseStaticMatrix<m,n,TransposedPattern<n,m,Pattern>::value,Scalar>
+        transpose() const
+        {
+            SparseStaticMatrix<m,n,TransposedPattern<n,m,Pattern>::value,Scalar> T;
+            SparseTerms<n,m,Pattern>::transpose(values, T.values);
+            return T;
+        }
+
+        /// @brief Adds the product of this matrix and a dense matrix to an output matrix (M += this * other)
+        template<Size q>
+        void
+        multiplyAccumulate(const Matrix<m,q,Scalar> &other, Matrix<n,q,Scalar> &M) const
+        {
+            SparseTerms<n,m,Pattern>::leftMultiply(values, other, M);
+        }
+
+        /// @brief Multiplies by a dense matrix, skipping the zeros of this one
+        template<Size q>
+        Matrix<n,q,Scalar>
+        operator *(const Matrix<m,q,Scalar> &other) const
+        {
+            Matrix<n,q,Scalar> M;
+            multiplyAccumulate(other, M);
+            return M;
+        }
+
+        /// @brief Multiplies by another sparse matrix. The pattern of the result is worked out at compile time.
+        template<Size q, const SparsityPattern<m,q> &Other_Pattern>
+        SparseStaticMatrix<n,q,ProductOfPatterns<n,m,q,Pattern,Other_Pattern>::value,Scalar>
+        operator *(const SparseStaticMatrix<m,q,Other_Pattern,Scalar> &other) const
+        {
+            SparseStaticMatrix<n,q,ProductOfPatterns<n,m,q,Pattern,Other_Pattern>::value,Scalar> M;
+            SparseProduct<n,m,q,Pattern,Other_Pattern>::apply(values, other.values, M.values);
+            return M;
+        }
+    }; // end SparseStaticMatrix class
+
+    template<Size n, Size m, const SparsityPattern<n,m> &Pattern, typename Scalar>
+    const int SparseStaticMatrix<n,m,Pattern,Scalar>::count;
+
+
+    /// @brief Multiplies a dense matrix by a sparse matrix, skipping the zeros of the sparse one
+    template<Size p, Size n, Size m, const SparsityPattern<n,m> &Pattern, typename Scalar>
+    Matrix<p,m,Scalar>
+    operator *(const Matrix<p,n,Scalar> &A, const SparseStaticMatrix<n,m,Pattern,Scalar> &B)
+    {
+        Matrix<p,m,Scalar> M;
+        SparseTerms<n,m,Pattern>::rightMultiply(A, B.values, M);
+        return M;
+    }
+
+}
@@ -0,0 +1,178 @@
+#include "TMM_text.hpp"
+
+#ifdef USING_STANDARD_LIBRARY
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// std::to_chars and std::from_chars for floating point need C++17 and a recent
+// standard library. Fall back to the C library without them.
+#if defined(__has_include)
+    #if __has_include(<charconv>) && __cplusplus >= 201703L
+        #include <charconv>
+    #endif
+#endif
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    #define TMM_HAS_CHARCONV 1
+#endif
+
+
+namespace tmm{
+
+    namespace {
+
+        bool isDelimiter(char c){
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == '[' || c == ']';
+        }
+
+        template<typename T>
+        char*
+        format(char *first, char *last, T value, unsigned char precision)
+        {
+            #ifdef TMM_HAS_CHARCONV
+            std::to_chars_result result = precision == TextFormat::shortest
+                ? std::to_chars(first, last, value)
+                : std::to_chars(first, last, value, std::chars_format::fixed, precision);
+            return result.ec == std::errc() ? result.ptr : first;
+            #else
+            char text[400]; // large enough for any fixed-point double
+            int length = precision == TextFormat::shortest
+                ? std::snprintf(text, sizeof(text), sizeof(T) == sizeof(float) ? "%.9g" : "%.17g", (double)value)
+                : std::snprintf(text, sizeof(text), "%.*f", (int)precision, (double)value);
+            if(length < 0 || length >= (int)sizeof(text) || length > last - first) return first;
+            std::memcpy(first, text, length);
+            return first + length;
+            #endif
+        }
+
+        template<typename T>
+        const char*
+        parse(const char *first, const char *last, T &value)
+        {
+            #ifdef TMM_HAS_CHARCONV
+            if(first != last && *first == '+') first++; // from_chars doesn't accept a leading '+'
+            std::from_chars_result result = std::from_chars(first, last, value);
+            return result.ec == std::errc() ? result.ptr : first;
+            #else
+            char text[64];
+            const std::size_t length = (std::size_t)(last - first) < sizeof(text) ? last - first : sizeof(text) - 1;
+            std::memcpy(text, first, length);
+            text[length] = 0;
+            char *end;
+            value = (T)std::strtod(text, &end);
+            return first + (end - text);
+            #endif
+        }
+
+    }
+
+
+    char* formatScalar(char *first, char *last, double value, unsigned char precision){ return format(first, last, value, precision); }
+    char* formatScalar(char *first, char *last, float value, unsigned char precision){ return format(first, last, value, precision); }
+    const char* parseScalar(const char *first, const char *last, double &value){ return parse(first, last, value); }
+    const char* parseScalar(const char *first, const char *last, float &value){ return parse(first, last, value); }
+
+
+
+    TextWriter::TextWriter(std::ostream &out, std::size_t capacity)
+        : out(out), owned(capacity ? capacity : 1), buffer(owned.data()), capacity(owned.size()) {}
+
+
+    // Without any storage, a one-byte buffer of its own passes each character straight on
+    TextWriter::TextWriter(std::ostream &out, char *storage, std::size_t capacity)
+        : out(out), owned(capacity ? 0 : 1), buffer(capacity ? storage : owned.data()), capacity(capacity ? capacity : 1) {}
+
+
+    TextWriter::~TextWriter(){
+        flush();
+    }
+
+
+    void
+    TextWriter::flush(){
+        out.write(buffer, used);
+        used = 0;
+    }
+
+
+    template<typename T>
+    void
+    TextWriter::formatValue(T value, unsigned char precision){
+        char *end = formatScalar(buffer + used, buffer + capacity, value, precision);
+        if(end == buffer + used){
+            // Out of room: make space and try again, formatting numbers longer than the buffer on the side
+            flush();
+            end = formatScalar(buffer, buffer + capacity, value, precision);
+            if(end == buffer){
+                std::vector<char> large(4096);
+                char *large_end = formatScalar(large.data(), large.data() + large.size(), value, precision);
+                out.write(large.data(), large_end - large.data());
+                return;
+            }
+        }
+        used = end - buffer;
+    }
+
+
+    void TextWriter::scalar(double value, unsigned char precision){ formatValue(value, precision); }
+    void TextWriter::scalar(float value, unsigned char precision){ formatValue(value, precision); }
+
+
+
+    TextReader::TextReader(std::istream &in, std::size_t capacity)
+        : in(in), buffer(capacity ? capacity : 1) {}
+
+
+    bool
+    TextReader::fill(){
+        if(!in) return false;
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        if(end == buffer.size()) return false; // a single token fills the whole buffer
+        in.read(buffer.data() + end, buffer.size() - end);
+        const std::size_t count = (std::size_t)in.gcount();
+        end += count;
+        return count > 0;
+    }
+
+
+    template<typename T>
+    bool
+    TextReader::nextValue(T &value){
+        // Skip punctuation between numbers
+        for(;;){
+            while(begin < end && isDelimiter(buffer[begin])) begin++;
+            if(begin < end) break;
+            if(!fill()) return false;
+        }
+
+        // Make sure the whole token is in the buffer
+        std::size_t token_end = begin;
+        for(;;){
+            while(token_end < end && !isDelimiter(buffer[token_end])) token_end++;
+            if(token_end < end) break;
+            const std::size_t offset = token_end - begin;
+            if(offset == buffer.size()) return false; // the token doesn't fit in the buffer
+            if(!fill()){
+                token_end = end;
+                break;
+            }
+            token_end = begin + offset;
+        }
+
+        const char *first = buffer.data() + begin;
+        const char *parsed = parseScalar(first, buffer.data() + token_end, value);
+        if(parsed == first) return false;
+        begin = parsed - buffer.data();
+        return true;
+    }
+
+
+    bool TextReader::next(double &value){ return nextValue(value); }
+    bool TextReader::next(float &value){ return nextValue(value); }
+
+}
+
+#endif // ifdef USING_STANDARD_LIBRARY
@@ -0,0 +1,203 @@
+// Buffered text output and parsing for matrices.
+//
+// Matrix::printTo() and Matrix::formatTo() lay matrices out as TSV, CSV or
+// JSON arrays. The actual characters go through a writer that batches them:
+//   - TextWriter (host) formats numbers with std::to_chars and writes to a
+//     std::ostream in large blocks, never flushing on its own,
+//   - PrintWriter (Arduino) fills a small buffer and hands it to Print::print
+//     in one call, instead of calling print once per element.
+// TextReader (host) streams matrices back in from any of these layouts.
+//
+// This file is included by TMM_matrix.hpp.
+
+#pragma once
+
+#ifdef USING_STANDARD_LIBRARY
+    #include <cstddef>
+    #include <istream>
+    #include <ostream>
+    #include <vector>
+#endif
+#ifdef ARDUINO
+    #include <math.h>
+    #include <stdlib.h>
+    #include <string.h>
+#endif
+
+
+namespace tmm{
+
+    enum class TextLayout : unsigned char {
+        TSV,  // tab-separated values, one row per line
+        CSV,  // comma-separated values, one row per line
+        JSON  // a nested array on a single line, like [[1,2],[3,4]]
+    };
+
+
+    /// @brief Controls how matrices are written as text
+    struct TextFormat{
+        /// @brief Pass as the precision to print the shortest text that reads back to the same value
+        static const unsigned char shortest = 255;
+
+        TextLayout layout;
+        unsigned char precision; // digits after the decimal point, or shortest
+
+        TextFormat(TextLayout layout = TextLayout::TSV, unsigned char precision = shortest)
+            : layout(layout), precision(precision) {}
+    };
+
+
+    #ifdef USING_STANDARD_LIBRARY
+
+    /// @brief Formats a number into [first, last)
+    /// @param precision digits after the decimal point, or TextFormat::shortest
+    /// @return one past the last character written, or first if the number doesn't fit
+    char* formatScalar(char *first, char *last, double value, unsigned char precision);
+    char* formatScalar(char *first, char *last, float value, unsigned char precision);
+
+    /// @brief Parses a number at the start of [first, last)
+    /// @return one past the last character parsed, or first if there is no number there
+    const char* parseScalar(const char *first, const char *last, double &value);
+    const char* parseScalar(const char *first, const char *last, float &value);
+
+
+    /// @brief Buffers formatted text and writes it to a stream in large blocks
+    /// @note Nothing is written until the buffer fills, flush() is called, or the writer is destroyed.
+    /// One writer can be reused for many matrices, e.g. for a log file.
+    class TextWriter{
+        public:
+
+        /// @param capacity size of the buffer in bytes, at least 1
+        explicit TextWriter(std::ostream &out, std::size_t capacity = 1 << 16);
+
+        /// @brief Buffers in storage owned by the caller, e.g. a small array on the stack
+        /// @param capacity size of storage in bytes. With 0, storage is never touched and every character is written on its own.
+        TextWriter(std::ostream &out, char *storage, std::size_t capacity);
+        ~TextWriter();
+
+        TextWriter(const TextWriter&) = delete;
+        TextWriter& operator=(const TextWriter&) = delete;
+
+        void put(char c){
+            if(used == capacity) flush();
+            buffer[used++] = c;
+        }
+
+        void scalar(double value, unsigned char precision);
+        void scalar(float value, unsigned char precision);
+
+        /// @brief Writes any other arithmetic type through double
+        template<typename T>
+        void scalar(T value, unsigned char precision){ scalar((double)value, precision); }
+
+        /// @brief Writes everything buffered so far to the stream (without flushing the stream itself)
+        void flush();
+
+        private:
+
+        template<typename T> void formatValue(T value, unsigned char precision);
+
+        std::ostream &out;
+        std::vector<char> owned;
+        char *buffer;
+        std::size_t capacity;
+        std::size_t used = 0;
+    }; // end TextWriter class
+
+
+    /// @brief Reads numbers from a stream in large blocks, skipping any TSV, CSV or JSON punctuation between them
+    class TextReader{
+        public:
+
+        /// @param capacity size of the buffer in bytes. Only numbers shorter than this can be read.
+        explicit TextReader(std::istream &in, std::size_t capacity = 1 << 16);
+
+        TextReader(const TextReader&) = delete;
+        TextReader& operator=(const TextReader&) = delete;
+
+        /// @brief Reads the next number
+        /// @return false at the end of the stream, if the next token isn't a number, or if it is too long for the buffer
+        bool next(double &value);
+        bool next(float &value);
+
+        /// @brief Reads any other arithmetic type through double
+        template<typename T>
+        bool next(T &value){
+            double d;
+            if(!next(d)) return false;
+            value = (T)d;
+            return true;
+        }
+
+        private:
+
+        template<typename T> bool nextValue(T &value);
+        bool fill();  // moves unread text to the front of the buffer and reads more; false at end of stream
+
+        std::istream &in;
+        std::vector<char> buffer;
+        std::size_t begin = 0, end = 0;
+    }; // end TextReader class
+
+    #endif // ifdef USING_STANDARD_LIBRARY
+
+
+    #ifdef ARDUINO
+
+    /// @brief Collects formatted text in a small buffer and prints it in batches
+    class PrintWriter{
+        public:
+
+        explicit PrintWriter(Print &serial) : serial(serial) {}
+        ~PrintWriter(){ flush(); }
+
+        void put(char c){
+            if(used == sizeof(buffer) - 1) flush();
+            buffer[used++] = c;
+        }
+
+        /// @brief Writes a number, fixed-width like the rest of the column when dtostrf is available
+        /// @param precision digits after the decimal point, at most 16; TextFormat::shortest prints 3
+        /// @note Numbers of 1e16 or more, infinities and NaNs go through Print::print, or dtostre on AVR.
+        void scalar(double value, unsigned char precision){
+            if(precision == TextFormat::shortest) precision = 3;
+            if(precision > max_precision) precision = max_precision;
+            // sign, integer digits (one more if rounding carries), point, fraction and terminator
+            char text[1 + 17 + 1 + max_precision + 1];
+            if(dtostrf_func && fabs(value) < 1e16){
+                dtostrf_func(value, 6, precision, text);
+            }
+            else{
+                #ifdef __AVR__
+                dtostre(value, text, precision > 7 ? 7 : precision, 0);
+                #else
+                flush();
+                serial.print(value, precision);
+                return;
+                #endif
+            }
+            const size_t length = strlen(text);
+            if(used + length >= sizeof(buffer)) flush();
+            memcpy(buffer + used, text, length);
+            used += length;
+        }
+
+        void flush(){
+            if(!used) return;
+            buffer[used] = 0;
+            serial.print(buffer);
+            used = 0;
+        }
+
+        private:
+
+        static const unsigned char max_precision = 16;
+
+        Print &serial;
+        char buffer[48];
+        size_t used = 0;
+    }; // end PrintWriter class
+
+    #endif // ifdef ARDUINO
+
+}
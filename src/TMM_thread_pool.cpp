@@ -0,0 +1,113 @@
+#include "TMM_thread_pool.hpp"
+
+#ifdef TMM_ENABLE_THREADS
+
+namespace tmm{
+
+    namespace {
+        // Set while a thread runs a task so nested parallelFor calls don't deadlock
+        thread_local bool insideTask = false;
+    }
+
+
+    ThreadPool::ThreadPool(unsigned int threads){
+        start(threads);
+    }
+
+
+    ThreadPool::~ThreadPool(){
+        stop();
+    }
+
+
+    ThreadPool&
+    ThreadPool::shared(){
+        static ThreadPool pool(std::thread::hardware_concurrency());
+        return pool;
+    }
+
+
+    void
+    ThreadPool::resize(unsigned int threads){
+        std::lock_guard<std::mutex> submit(submitMutex);
+        stop();
+        start(threads);
+    }
+
+
+    void
+    ThreadPool::start(unsigned int threads){
+        stopping = false;
+        for(unsigned int i = 1; i < threads; i++) workers.emplace_back(&ThreadPool::workerLoop, this, generation);
+    }
+
+
+    void
+    ThreadPool::stop(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(std::thread &worker : workers) worker.join();
+        workers.clear();
+    }
+
+
+    void
+    ThreadPool::runTasks(){
+        insideTask = true;
+        for(int i = next++; i < count; i = next++) (*task)(i);
+        insideTask = false;
+    }
+
+
+    void
+    ThreadPool::workerLoop(unsigned long seen){
+        for(;;){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]{ return stopping || generation != seen; });
+                if(stopping) return;
+                seen = generation;
+            }
+            runTasks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished++;
+            }
+            done.notify_one();
+        }
+    }
+
+
+    void
+    ThreadPool::parallelFor(int count, const std::function<void(int)> &task){
+        if(insideTask || workers.empty() || count <= 1){
+            for(int i = 0; i < count; i++) task(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(submitMutex);
+        dispatched++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->task  = &task;
+            this->count = count;
+            next = 0;
+            finished = 0;
+            generation++;
+        }
+        wake.notify_all();
+
+        // The calling thread works too, then waits until every worker has seen this job,
+        // so no worker can pick up an index after the task goes out of scope
+        runTasks();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]{ return finished == workers.size(); });
+        this->task = nullptr;
+    }
+
+}
+
+#endif // ifdef TMM_ENABLE_THREADS
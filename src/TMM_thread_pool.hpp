@@ -0,0 +1,77 @@
+// A small shared pool of worker threads for splitting large matrix operations.
+//
+// Threading is opt-in: define TMM_ENABLE_THREADS (the CMake option
+// tinymatrixmath_ENABLE_THREADS does this) to compile the pool and let
+// large products and decompositions use it. Small matrices never touch it.
+
+#pragma once
+
+#ifdef TMM_ENABLE_THREADS
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Products with at least this many multiply-adds are split across the pool
+#ifndef TMM_THREADS_THRESHOLD
+    #define TMM_THREADS_THRESHOLD (128L*128L*64L)
+#endif
+
+
+namespace tmm{
+
+    class ThreadPool{
+        public:
+
+        /// @brief Creates a pool that runs tasks on the calling thread plus threads-1 workers
+        /// @param threads the total number of threads that run tasks, including the caller
+        explicit ThreadPool(unsigned int threads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// @brief The pool shared by all matrix operations, sized to the hardware concurrency
+        static ThreadPool& shared();
+
+        /// @brief The total number of threads that run tasks, including the caller
+        unsigned int size() const { return (unsigned int)workers.size() + 1; }
+
+        /// @brief Stops all workers and starts a new set of them
+        /// @param threads the total number of threads that run tasks, including the caller
+        void resize(unsigned int threads);
+
+        /// @brief Calls task(i) for every i in [0, count) and waits for all calls to finish
+        /// @note Calls made from inside a task run serially on the calling thread.
+        void parallelFor(int count, const std::function<void(int)> &task);
+
+        /// @brief The number of parallelFor calls that were handed to the workers, rather than run serially
+        unsigned long jobs() const { return dispatched; }
+
+        private:
+
+        void start(unsigned int threads);
+        void stop();
+        void workerLoop(unsigned long seen);
+        void runTasks();
+
+        std::vector<std::thread> workers;
+        std::mutex submitMutex;  // one parallelFor at a time
+        std::mutex mutex;        // guards everything below
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int)> *task = nullptr;
+        int count = 0;
+        std::atomic<int> next{0};
+        unsigned int finished = 0;  // workers done with the current job
+        unsigned long generation = 0;
+        std::atomic<unsigned long> dispatched{0};
+        bool stopping = false;
+    }; // end ThreadPool class
+
+}
+
+#endif // ifdef TMM_ENABLE_THREADS
@@ -1,2 +1,12 @@
 #pragma once
-#include "TMM_matrix.hpp"
\ No newline at end of file
+#include "TMM_matrix.hpp"
+#include "TMM_decompositions.hpp"
+#include "TMM_dual.hpp"
+#include "TMM_expm.hpp"
+#include "TMM_inverse_updates.hpp"
+#include "TMM_pipeline.hpp"
+#include "TMM_product_chain.hpp"
+#include "TMM_quantized.hpp"
+#include "TMM_reductions.hpp"
+#include "TMM_sandwich.hpp"
+#include "TMM_sparse.hpp"
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "float_eq.hpp"
+#include "test_matrices.hpp"
+
+
+
+/// @brief Fills a matrix with a diagonally dominant pattern, so it is well-conditioned
+template<tmm::Size n>
+tmm::Matrix<n,n,double> well_conditioned(){
+  tmm::Matrix<n,n,double> A;
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < n; j++){
+      A[i][j] = (double)((i*7 + j*13) % 17) / 17.0 - 0.5;
+    }
+    A[i][i] += n;
+  }
+  return A;
+}
+
+
+
+/// @brief A helper function that checks P*A = L*U and that luSolve inverts A
+template<tmm::Size n>
+void test_lu(){
+  tmm::Matrix<n,n,double> A = well_conditioned<n>();
+  tmm::Matrix<n,n,double> LU = A;
+  tmm::Size pivots[n];
+  ASSERT_TRUE(tmm::luDecompose(LU, pivots));
+
+  // Rebuild L*U and undo the row swaps
+  tmm::Matrix<n,n,double> L = tmm::Identity<n,double>();
+  tmm::Matrix<n,n,double> U;
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < n; j++){
+      if(j < i) L[i][j] = LU[i][j];
+      else      U[i][j] = LU[i][j];
+    }
+  }
+  tmm::Matrix<n,n,double> PA = A;
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < n; j++){
+      double t = PA[i][j]; PA[i][j] = PA[pivots[i]][j]; PA[pivots[i]][j] = t;
+    }
+  }
+  ASSERT_TRUE(matrices_near(L*U, PA, 1e-9));
+
+  tmm::Matrix<n,n,double> X = tmm::Identity<n,double>();
+  tmm::luSolve(LU, pivots, X);
+  ASSERT_TRUE(matrices_near(A*X, tmm::Identity<n,double>(), 1e-9));
+}
+
+
+
+/// @brief A helper function that checks L*L^T = A and that choleskySolve inverts A
+template<tmm::Size n>
+void test_cholesky(){
+  tmm::Matrix<n,n,double> B = well_conditioned<n>();
+  tmm::Matrix<n,n,double> A = B * B.transpose();
+  tmm::Matrix<n,n,double> L = A;
+  ASSERT_TRUE(tmm::choleskyDecompose(L));
+
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = i+1; j < n; j++){
+      ASSERT_EQ(L[i][j], 0);
+    }
+  }
+  ASSERT_TRUE(matrices_near(L*L.transpose(), A, 1e-9 * n * n));
+
+  tmm::Matrix<n,n,double> X = tmm::Identity<n,double>();
+  tmm::choleskySolve(L, X);
+  ASSERT_TRUE(matrices_near(A*X, tmm::Identity<n,double>(), 1e-9));
+}
+
+
+
+/// @brief Test LU decomposition below and above the block size
+TEST(TMMTests, LU_Decomposition){
+  test_lu<1>();
+  test_lu<3>();
+  test_lu<10>();
+  test_lu<70>();
+  test_lu<130>();
+}
+
+
+
+/// @brief Test that LU decomposition pivots instead of dividing by a zero diagonal
+TEST(TMMTests, LU_Decomposition_Pivoting){
+  const float A_raw[3][3] = {
+    {0, 1, 2},
+    {1, 0, 3},
+    {4, -3, 8}
+  };
+  tmm::Matrix<3,3> A(A_raw);
+  tmm::Size pivots[3];
+  ASSERT_TRUE(tmm::luDecompose(A, pivots));
+  ASSERT_EQ(pivots[0], 2);
+
+  tmm::Matrix<3,1> b;
+  b[0][0] = 3; b[1][0] = 4; b[2][0] = 9; // A * [1, 1, 1]^T
+  tmm::luSolve(A, pivots, b);
+  for(tmm::Size i = 0; i < 3; i++) ASSERT_TRUE(float_eq(b[i][0], 1));
+}
+
+
+
+/// @brief Test that LU decomposition reports singular matrices
+TEST(TMMTests, LU_Decomposition_Singular){
+  const float A_raw[3][3] = {
+    {1, 2, 3},
+    {2, 4, 6},
+    {1, 0, 1}
+  };
+  tmm::Matrix<3,3> A(A_raw);
+  tmm::Size pivots[3];
+  ASSERT_FALSE(tmm::luDecompose(A, pivots));
+}
+
+
+
+/// @brief Test Cholesky decomposition below and above the block size
+TEST(TMMTests, Cholesky_Decomposition){
+  test_cholesky<1>();
+  test_cholesky<4>();
+  test_cholesky<33>();
+  test_cholesky<100>();
+}
+
+
+
+/// @brief Test that Cholesky decomposition rejects matrices that are not positive-definite
+TEST(TMMTests, Cholesky_Decomposition_Not_Positive_Definite){
+  const float A_raw[2][2] = {
+    {1, 2},
+    {2, 1}
+  };
+  tmm::Matrix<2,2> A(A_raw);
+  ASSERT_FALSE(tmm::choleskyDecompose(A));
+}
+
+
+
+/// @brief Test that a rank-1 update and downdate of a Cholesky factor match refactoring
+TEST(TMMTests, Cholesky_Update_Downdate){
+  tmm::Matrix<6,6,double> B = well_conditioned<6>();
+  tmm::Matrix<6,6,double> A = B * B.transpose();
+  tmm::Matrix<6,6,double> L = A;
+  ASSERT_TRUE(tmm::choleskyDecompose(L));
+
+  tmm::Matrix<6,1,double> x;
+  for(tmm::Size i = 0; i < 6; i++) x[i][0] = 0.7 * i - 1.5;
+  tmm::Matrix<6,6,double> A_up = A + x * x.transpose();
+
+  tmm::choleskyUpdate(L, x);
+  tmm::Matrix<6,6,double> expected = A_up;
+  ASSERT_TRUE(tmm::choleskyDecompose(expected));
+  ASSERT_TRUE(matrices_near(L, expected, 1e-9));
+
+  ASSERT_TRUE(tmm::choleskyDowndate(L, x));
+  expected = A;
+  ASSERT_TRUE(tmm::choleskyDecompose(expected));
+  ASSERT_TRUE(matrices_near(L, expected, 1e-9));
+}
+
+
+
+/// @brief Test that a downdate that loses positive-definiteness fails and leaves the factor unchanged
+TEST(TMMTests, Cholesky_Downdate_Not_Positive_Definite){
+  tmm::Matrix<3,3,double> L = tmm::Identity<3,double>();
+  tmm::Matrix<3,1,double> x;
+  x[1][0] = 1; // I - x*x^T is singular
+  ASSERT_FALSE(tmm::choleskyDowndate(L, x));
+  ASSERT_TRUE(matrices_near(L, tmm::Identity<3,double>(), 0));
+
+  x[1][0] = 0.5;
+  ASSERT_TRUE(tmm::choleskyDowndate(L, x));
+  ASSERT_NEAR(L[1][1], sqrt(0.75), 1e-12);
+}
+
+
+
+#ifdef TMM_ENABLE_THREADS
+/// @brief Test that the trailing updates of a 128x128 factorization run on the thread pool,
+/// even though each one alone is smaller than TMM_THREADS_THRESHOLD
+TEST(TMMTests, Decompositions_Threaded){
+  static_assert(tmm::useThreadedFactorization(128), "128x128 factorizations use the pool");
+  static_assert(!tmm::useThreadedFactorization(32), "small factorizations stay on the calling thread");
+
+  unsigned int threads = tmm::ThreadPool::shared().size();
+  tmm::ThreadPool::shared().resize(4);
+
+  unsigned long jobs = tmm::ThreadPool::shared().jobs();
+  test_lu<128>();
+  ASSERT_GE(tmm::ThreadPool::shared().jobs(), jobs + 3); // one per trailing update
+
+  jobs = tmm::ThreadPool::shared().jobs();
+  test_cholesky<128>();
+  ASSERT_GE(tmm::ThreadPool::shared().jobs(), jobs + 3);
+
+  tmm::ThreadPool::shared().resize(threads);
+}
+#endif
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include "TinyMatrixMath.hpp"
+#include "float_eq.hpp"
+#include "test_matrices.hpp"
+
+
+typedef tmm::Dual<double, 1> Dual1;
+typedef tmm::Dual<double, 3> Dual3;
+
+
+/// @brief Builds A + t*dA as a matrix of dual numbers in one variable t, evaluated at t = 0
+template<tmm::Size n>
+tmm::Matrix<n,n,Dual1> perturbed(const tmm::Matrix<n,n,double> &A, const tmm::Matrix<n,n,double> &dA){
+  tmm::Matrix<n,n,Dual1> result;
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < n; j++){
+      result[i][j] = A.data[i][j];
+      result[i][j].derivatives[0] = dA.data[i][j];
+    }
+  }
+  return result;
+}
+
+/// @brief The derivatives of a matrix of dual numbers in one variable
+template<tmm::Size n, tmm::Size m>
+tmm::Matrix<n,m,double> derivative(const tmm::Matrix<n,m,Dual1> &A){
+  tmm::Matrix<n,m,double> result;
+  for(tmm::Size i = 0; i < n; i++) for(tmm::Size j = 0; j < m; j++) result[i][j] = A.data[i][j].derivatives[0];
+  return result;
+}
+
+
+/// @brief A nonlinear measurement model written for any Scalar: range, bearing and a rotated x
+template<typename S>
+tmm::Matrix<3,1,S> measure(const tmm::Matrix<3,1,S> &x){
+  tmm::Matrix<3,1,S> z;
+  z[0][0] = sqrt(x.data[0][0]*x.data[0][0] + x.data[1][0]*x.data[1][0]);
+  z[1][0] = atan2(x.data[1][0], x.data[0][0]);
+  z[2][0] = cos(x.data[2][0]) * x.data[0][0] - sin(x.data[2][0]) * x.data[1][0] + exp(x.data[2][0]) / 2;
+  return z;
+}
+
+
+
+/// @brief Check the derivatives of scalar arithmetic and elementary functions
+TEST(TMMTests, Dual_Scalar_Rules){
+  const Dual3 x = Dual3::variable(0.5, 0);
+  const Dual3 y = Dual3::variable(2.0, 1);
+  const Dual3 f = x * y / sin(x) + 3 * log(y) - pow(x, 3.0) + 1 / y;
+
+  ASSERT_NEAR(f.value, 0.5*2/sin(0.5) + 3*log(2.0) - 0.125 + 0.5, 1e-12);
+  ASSERT_NEAR(f.derivatives[0], 2*(sin(0.5) - 0.5*cos(0.5))/(sin(0.5)*sin(0.5)) - 3*0.25, 1e-12);
+  ASSERT_NEAR(f.derivatives[1], 0.5/sin(0.5) + 1.5 - 0.25, 1e-12);
+  ASSERT_EQ(f.derivatives[2], 0.0);
+
+  // Comparisons and the explicit conversion only look at the value
+  ASSERT_TRUE(x < y && x < 1 && 0 < x && x == 0.5);
+  ASSERT_EQ((double)y, 2.0);
+}
+
+
+/// @brief One evaluation on dual numbers gives the exact Jacobian
+TEST(TMMTests, Dual_Jacobian){
+  const double x_raw[3][1] = {{3}, {4}, {0.3}};
+  const tmm::Matrix<3,1,double> x(x_raw);
+
+  tmm::Matrix<3,1,double> z;
+  const tmm::Matrix<3,3,double> J = tmm::jacobian(measure<Dual3>, x, &z);
+  ASSERT_TRUE(matrices_near(z, measure(x), 1e-12));
+
+  const double c = cos(0.3), s = sin(0.3);
+  const double expected_raw[3][3] = {
+    { 3/5.,   4/5.,   0},
+    {-4/25.,  3/25.,  0},
+    { c,     -s,     -s*3 - c*4 + exp(0.3)/2}
+  };
+  ASSERT_TRUE(matrices_near(J, tmm::Matrix<3,3,double>(expected_raw), 1e-12));
+}
+
+
+/// @brief Differentiate through the inverses, decompositions and the matrix exponential
+TEST(TMMTests, Dual_Through_Decompositions){
+  const double A_raw[5][5] = {
+    {6, 1, 0, 2, 1},
+    {1, 5, 1, 0, 0},
+    {0, 1, 7, 1, 2},
+    {2, 0, 1, 8, 1},
+    {1, 0, 2, 1, 9}
+  };
+  const double dA_raw[5][5] = {
+    { 1,  0, 2, 0, -1},
+    { 0,  3, 0, 1,  0},
+    { 2,  0, 0, 0,  1},
+    { 0,  1, 0, 2,  0},
+    {-1,  0, 1, 0,  1}
+  };
+  const tmm::Matrix<5,5,double> A(A_raw), dA(dA_raw); // A and dA are symmetric
+  const tmm::Matrix<5,5,Dual1> At = perturbed(A, dA);
+  const tmm::Matrix<5,5,double> Ainv = A.inverse();
+  const tmm::Matrix<5,5,double> dAinv = (Ainv * dA * Ainv).negate(); // d(A^-1) = -A^-1 dA A^-1
+
+  // Recursive inverse and determinant (5x5). d(det A) = det(A) trace(A^-1 dA)
+  ASSERT_TRUE(matrices_near(derivative(At.inverse()), dAinv, 1e-9));
+  double trace = 0;
+  const tmm::Matrix<5,5,double> AinvdA = Ainv * dA;
+  for(tmm::Size i = 0; i < 5; i++) trace += AinvdA.data[i][i];
+  ASSERT_NEAR(At.determinant().derivatives[0], A.determinant() * trace, 1e-6);
+
+  // Closed-form inverse (3x3)
+  const tmm::Matrix<3,3,double> B = A.get<3,3>(0,0), dB = dA.get<3,3>(0,0);
+  const tmm::Matrix<3,3,double> Binv = B.inverse();
+  ASSERT_TRUE(matrices_near(derivative(perturbed(B, dB).inverse()), (Binv * dB * Binv).negate(), 1e-9));
+
+  // LU solve of A x = b
+  const double b_raw[5][1] = {{1}, {2}, {3}, {4}, {5}};
+  const tmm::Matrix<5,1,double> b(b_raw);
+  tmm::Matrix<5,5,Dual1> LU = At;
+  tmm::Size pivots[5];
+  ASSERT_TRUE(tmm::luDecompose(LU, pivots));
+  tmm::Matrix<5,1,Dual1> x = tmm::Matrix<5,1,Dual1>(b);
+  tmm::luSolve(LU, pivots, x);
+  ASSERT_TRUE(matrices_near(derivative(x), dAinv * b, 1e-9));
+
+  // Cholesky: L dL^T + dL L^T = dA
+  tmm::Matrix<5,5,Dual1> L = At;
+  ASSERT_TRUE(tmm::choleskyDecompose(L));
+  const tmm::Matrix<5,5,double> L0 = tmm::dualValues(L), dL = derivative(L);
+  ASSERT_TRUE(matrices_near(L0 * dL.transpose() + dL * L0.transpose(), dA, 1e-9));
+
+  // d/dt expm(t A) at t = 1 is A expm(A)
+  const tmm::Matrix<5,5,double> small = A * 0.05;
+  tmm::Matrix<5,5,Dual1> tA = perturbed(small, small);
+  const tmm::Matrix<5,5,Dual1> E = tmm::expm(tA);
+  ASSERT_TRUE(matrices_near(derivative(E), small * tmm::expm(small), 1e-9));
+}
+
+
+/// @brief Matrices of different element types convert and compare
+TEST(TMMTests, Mixed_Scalar_Matrices){
+  const float A_raw[2][2] = {{1, 2}, {3, 4.5f}};
+  const tmm::Matrix<2,2,float> A(A_raw);
+  const tmm::Matrix<2,2,double> B(A_raw);
+  const tmm::Matrix<2,2,double> C(A);
+  ASSERT_TRUE(A == B);
+  ASSERT_TRUE(B == C);
+  ASSERT_TRUE(B.equals(A, 1e-9));
+  ASSERT_FALSE(B.equals(A * 1.001f, 1e-9));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include "TinyMatrixMath.hpp"
+#include "float_eq.hpp"
+
+
+
+/// @brief Test that the exponential of zero is the identity
+TEST(TMMTests, Matrix_Exponential_Zero){
+  tmm::Matrix<3,3> E = tmm::expm(tmm::Zeros<3,3>());
+  for(tmm::Size i = 0; i < 3; i++){
+    for(tmm::Size j = 0; j < 3; j++){
+      ASSERT_TRUE(float_eq(E[i][j], i==j?1:0));
+    }
+  }
+}
+
+
+
+/// @brief Test diagonal and nilpotent matrices, whose exponentials are known exactly
+TEST(TMMTests, Matrix_Exponential_Known){
+  // Each diagonal element lands in a different Pade order, or needs scaling
+  const double values[] = {0.001, 0.2, 0.9, 2, 5, 30, -12};
+  for(double d : values){
+    tmm::Matrix<2,2,double> A;
+    A[0][0] = d;
+    A[1][1] = -d / 2;
+    tmm::Matrix<2,2,double> E = tmm::expm(A);
+    ASSERT_NEAR(E[0][0] / exp(d), 1, 1e-13);
+    ASSERT_NEAR(E[1][1] / exp(-d / 2), 1, 1e-13);
+    ASSERT_NEAR(E[0][1], 0, 1e-13);
+  }
+
+  // A constant-velocity model: e^(A dt) = [1 dt; 0 1]
+  const float A_raw[2][2] = {
+    {0, 1},
+    {0, 0}
+  };
+  tmm::Matrix<2,2> E = tmm::expm(tmm::Matrix<2,2>(A_raw) * 0.25f);
+  ASSERT_TRUE(float_eq(E[0][0], 1));
+  ASSERT_TRUE(float_eq(E[0][1], 0.25f));
+  ASSERT_TRUE(float_eq(E[1][0], 0));
+  ASSERT_TRUE(float_eq(E[1][1], 1));
+}
+
+
+
+/// @brief Test a rotation generator with a large norm, which needs scaling and squaring
+TEST(TMMTests, Matrix_Exponential_Rotation){
+  const double t = 10;
+  tmm::Matrix<2,2,double> A;
+  A[0][1] = -t;
+  A[1][0] =  t;
+  tmm::Matrix<2,2,double> E = tmm::expm(A);
+  ASSERT_NEAR(E[0][0],  cos(t), 1e-12);
+  ASSERT_NEAR(E[0][1], -sin(t), 1e-12);
+  ASSERT_NEAR(E[1][0],  sin(t), 1e-12);
+  ASSERT_NEAR(E[1][1],  cos(t), 1e-12);
+
+  tmm::Matrix<2,2> Af;
+  Af[0][1] = -(float)t;
+  Af[1][0] =  (float)t;
+  tmm::Matrix<2,2> Ef = tmm::expm(Af);
+  ASSERT_NEAR(Ef[0][0], cos(t), 1e-5);
+  ASSERT_NEAR(Ef[1][0], sin(t), 1e-5);
+}
+
+
+
+/// @brief Test Van Loan discretization of a scalar Ornstein-Uhlenbeck process
+TEST(TMMTests, Van_Loan_Discretization){
+  const double a = 0.5, q = 2, dt = 0.1;
+  tmm::Matrix<1,1,double> A = -a;
+  tmm::Matrix<1,1,double> Qc = q;
+  tmm::Matrix<1,1,double> Phi, Qd;
+  tmm::vanLoanDiscretize(A, Qc, dt, Phi, Qd);
+  ASSERT_NEAR(Phi[0][0], exp(-a*dt), 1e-13);
+  ASSERT_NEAR(Qd[0][0], q * (1 - exp(-2*a*dt)) / (2*a), 1e-13);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+
+
+
+/// @brief Fills a matrix with small integers so products are exact in floating point
+template<tmm::Size n, tmm::Size m>
+void fill_pattern(tmm::Matrix<n,m> &A, int seed){
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < m; j++){
+      A[i][j] = (float)((i*7 + j*3 + seed) % 11) - 5;
+    }
+  }
+}
+
+
+
+/// @brief A helper function that compares operator* against a reference triple loop
+/// @tparam n the number of rows in the left-hand matrix
+/// @tparam m the number of columns in the left-hand matrix
+/// @tparam q the number of columns in the right-hand matrix
+template<tmm::Size n, tmm::Size m, tmm::Size q>
+void test_product(){
+  tmm::Matrix<n,m> A;
+  tmm::Matrix<m,q> B;
+  fill_pattern(A, 1);
+  fill_pattern(B, 4);
+
+  tmm::Matrix<n,q> C = A * B;
+
+  for(tmm::Size i = 0; i < n; i++){
+    for(tmm::Size j = 0; j < q; j++){
+      float expected = 0;
+      for(tmm::Size k = 0; k < m; k++) expected += A[i][k] * B[k][j];
+      ASSERT_EQ(C[i][j], expected);
+    }
+  }
+}
+
+
+
+/// @brief Ensure the blocked kernel is selected only for large products
+TEST(TMMTests, Blocked_Product_Threshold){
+  ASSERT_FALSE(tmm::useBlockedProduct(3, 3, 3));
+  ASSERT_FALSE(tmm::useBlockedProduct(200, 200, 1));
+  ASSERT_TRUE (tmm::useBlockedProduct(64, 64, 64));
+  ASSERT_TRUE (tmm::useBlockedProduct(255, 255, 255));
+}
+
+
+
+/// @brief Test products on both sides of the blocking threshold
+TEST(TMMTests, Matrix_Product_Blocked){
+  test_product<5, 7, 3>();
+  test_product<64, 64, 64>();
+  test_product<100, 70, 130>(); // edges that are not multiples of any block size
+  test_product<200, 200, 200>();
+}
+
+
+
+/// @brief Test the blocked kernel reading its left-hand operand as a transpose
+TEST(TMMTests, Blocked_Product_Transposed_Operand){
+  tmm::Matrix<70,90> A;
+  tmm::Matrix<70,80> B;
+  fill_pattern(A, 2);
+  fill_pattern(B, 5);
+
+  // C = A^T * B, reading A with swapped strides
+  tmm::Matrix<90,80> C;
+  tmm::gemm<float>(90, 80, 70, 1.f,
+    &A.data[0][0], 1, 90,
+    &B.data[0][0], 80, 1,
+    &C.data[0][0], 80);
+
+  tmm::Matrix<90,80> expected = A.transpose() * B;
+  ASSERT_TRUE(C.equals<float>(expected, 0));
+}
+
+
+
+/// @brief Test the blocked kernel on doubles and on dual numbers, which use other register tiles and shallower packed blocks
+TEST(TMMTests, Blocked_Product_Element_Types){
+  static_assert(tmm::GemmBlocking<double>::KC * sizeof(double) == tmm::GemmBlocking<float>::KC * sizeof(float),
+                "the packed blocks take the same space for every element type");
+  static_assert(tmm::GemmBlocking<tmm::Dual<float,6>>::KC < tmm::GemmBlocking<double>::KC, "larger elements get shallower blocks");
+
+  tmm::Matrix<100,70,double> A;
+  tmm::Matrix<70,130,double> B;
+  for(tmm::Size i = 0; i < 100; i++) for(tmm::Size k = 0; k < 70; k++) A[i][k] = (double)((i*7 + k*3 + 1) % 11) - 5;
+  for(tmm::Size k = 0; k < 70; k++) for(tmm::Size j = 0; j < 130; j++) B[k][j] = (double)((k*7 + j*3 + 4) % 11) - 5;
+  const tmm::Matrix<100,130,double> C = A * B;
+  for(tmm::Size i = 0; i < 100; i++) for(tmm::Size j = 0; j < 130; j++){
+    double expected = 0;
+    for(tmm::Size k = 0; k < 70; k++) expected += A[i][k] * B[k][j];
+    ASSERT_EQ(C.data[i][j], expected);
+  }
+
+  // The derivative of A(x) * B with A(x) = A0 + x A1 is A1 * B
+  typedef tmm::Dual<float,1> D;
+  tmm::Matrix<64,64> A0, A1, B0;
+  fill_pattern(A0, 1);
+  fill_pattern(A1, 2);
+  fill_pattern(B0, 3);
+  tmm::Matrix<64,64,D> Ad, Bd;
+  for(tmm::Size i = 0; i < 64; i++) for(tmm::Size j = 0; j < 64; j++){
+    Ad[i][j] = D(A0[i][j]);
+    Ad[i][j].derivatives[0] = A1[i][j];
+    Bd[i][j] = D(B0[i][j]);
+  }
+  const tmm::Matrix<64,64,D> Cd = Ad * Bd;
+  const tmm::Matrix<64,64> value = A0 * B0, derivative = A1 * B0;
+  for(tmm::Size i = 0; i < 64; i++) for(tmm::Size j = 0; j < 64; j++){
+    ASSERT_EQ(Cd.data[i][j].value, value.data[i][j]);
+    ASSERT_EQ(Cd.data[i][j].derivatives[0], derivative.data[i][j]);
+  }
+}
+
+
+
+#ifdef TMM_ENABLE_THREADS
+/// @brief Ensure the thread pool runs every task exactly once, including nested calls
+TEST(TMMTests, Thread_Pool_Parallel_For){
+  tmm::ThreadPool pool(4);
+  std::atomic<int> counts[64];
+  for(int i = 0; i < 64; i++) counts[i] = 0;
+  for(int trial = 0; trial < 100; trial++){
+    pool.parallelFor(64, [&](int i){
+      counts[i]++;
+      pool.parallelFor(2, [](int){}); // runs serially instead of deadlocking
+    });
+  }
+  for(int i = 0; i < 64; i++) ASSERT_EQ(counts[i], 100);
+}
+
+
+
+/// @brief Test large products split across the shared thread pool
+TEST(TMMTests, Matrix_Product_Threaded){
+  unsigned int threads = tmm::ThreadPool::shared().size();
+  tmm::ThreadPool::shared().resize(4);
+  test_product<128, 128, 128>();
+  test_product<200, 150, 255>();
+  tmm::ThreadPool::shared().resize(threads);
+}
+#endif
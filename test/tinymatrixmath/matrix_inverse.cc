@@ -4,8 +4,6 @@
 
 
 
-/* TODO when inverse is implemented better
-
 /// @brief Test identity matrix inversion on a 2x2 matrix
 TEST(TMMTests, Matrix_Inversion_2x2_Identity){
   tmm::Matrix<2,2> A = tmm::Identity<2>();
@@ -109,9 +107,9 @@ TEST(TMMTests, Matrix_Inversion_4x4){
   tmm::Matrix<4,4> A(A_raw);
   const float A_inv_raw[4][4] = {
     { 1,    0,    0,    0  },
-    { 6/5, -1/5, -4/5,  4/5},
-    {-7/5,  2/5,  3/5, -3/5},
-    { 4/5, -4/5, -1/5,  6/5},
+    { 6.f/5, -1.f/5, -4.f/5,  4.f/5},
+    {-7.f/5,  2.f/5,  3.f/5, -3.f/5},
+    { 4.f/5, -4.f/5, -1.f/5,  6.f/5},
   };
   tmm::Matrix<4,4> A_inv = A.inverse();
   // Compare each element of the inverse to the expected value
@@ -123,4 +121,118 @@ TEST(TMMTests, Matrix_Inversion_4x4){
 }
 
 
-*/
\ No newline at end of file
+
+
+/// @brief Test matrix inversion on a 5x5 matrix, which uses the adjugate instead of a closed form
+TEST(TMMTests, Matrix_Inversion_5x5){
+  const float A_raw[5][5] = {
+    {4, 1, 0, 0, 2},
+    {1, 5, 1, 0, 0},
+    {0, 1, 6, 1, 0},
+    {0, 0, 1, 7, 1},
+    {2, 0, 0, 1, 8}
+  };
+  tmm::Matrix<5,5> A(A_raw);
+  tmm::Matrix<5,5> A_inv;
+  ASSERT_TRUE(A.inverse(A_inv));
+  tmm::Matrix<5,5> I = A * A_inv;
+  for(tmm::Size i = 0; i < 5; i++){
+    for(tmm::Size j = 0; j < 5; j++){
+      ASSERT_TRUE(float_eq(I[i][j], i==j?1:0));
+    }
+  }
+}
+
+
+
+/// @brief Test that the closed-form and recursive determinants agree with known values
+TEST(TMMTests, Matrix_Determinant){
+  const float A_raw[3][3] = {
+    {2, 0, -1},
+    {5, 1,  0},
+    {0, 1,  3}
+  };
+  tmm::Matrix<3,3> A(A_raw);
+  ASSERT_TRUE(float_eq(A.determinant(), 1));
+
+  const float B_raw[4][4] = {
+    {1, 0, 0, 0},
+    {2, 3, 4, 0},
+    {2, 0, 2, 1},
+    {1, 2, 3, 1}
+  };
+  tmm::Matrix<4,4> B(B_raw);
+  ASSERT_TRUE(float_eq(B.determinant(), 5));
+
+  // 5x5 expands along the first row into 4x4 closed forms
+  tmm::Matrix<5,5> C = tmm::Identity<5>() * 2;
+  C[0][4] = 1;
+  C[4][0] = 1;
+  ASSERT_TRUE(float_eq(C.determinant(), 24));
+}
+
+
+
+/// @brief Test that the cofactor matrix has the checkerboard of signs
+TEST(TMMTests, Matrix_Cofactor){
+  const float A_raw[3][3] = {
+    {1, 2, 3},
+    {0, 4, 5},
+    {1, 0, 6}
+  };
+  const float C_raw[3][3] = {
+    { 24,  5, -4},
+    {-12,  3,  2},
+    { -2, -5,  4}
+  };
+  tmm::Matrix<3,3> A(A_raw);
+  tmm::Matrix<3,3> C = A.cofactor();
+  for(tmm::Size i = 0; i < 3; i++){
+    for(tmm::Size j = 0; j < 3; j++){
+      ASSERT_TRUE(float_eq(C[i][j], C_raw[i][j]));
+    }
+  }
+}
+
+
+
+/// @brief Test that singular matrices are reported
+TEST(TMMTests, Matrix_Inversion_Singular){
+  const float A_raw[3][3] = {
+    {1, 2, 3},
+    {2, 4, 6},
+    {1, 0, 1}
+  };
+  tmm::Matrix<3,3> A(A_raw);
+  tmm::Matrix<3,3> A_inv;
+  ASSERT_FALSE(A.inverse(A_inv));
+
+  tmm::Matrix<2,2> B = 1;
+  tmm::Matrix<2,2> B_inv;
+  ASSERT_FALSE(B.inverse(B_inv));
+
+  tmm::Matrix<4,4> C;
+  tmm::Matrix<4,4> C_inv;
+  ASSERT_FALSE(C.inverse(C_inv));
+}
+
+
+
+/// @brief Test the rigid transform inverse against the general 4x4 inverse
+TEST(TMMTests, Rigid_Transform_Inversion){
+  const float c = 0.6f, s = 0.8f;
+  const float T_raw[4][4] = {
+    {c, -s, 0,  1},
+    {s,  c, 0, -2},
+    {0,  0, 1,  3},
+    {0,  0, 0,  1}
+  };
+  tmm::Matrix<4,4> T(T_raw);
+  tmm::Matrix<4,4> T_inv = tmm::rigidTransformInverse(T);
+  tmm::Matrix<4,4> expected = T.inverse();
+  for(tmm::Size i = 0; i < 4; i++){
+    for(tmm::Size j = 0; j < 4; j++){
+      ASSERT_TRUE(float_eq(T_inv[i][j], expected[i][j]));
+    }
+  }
+}
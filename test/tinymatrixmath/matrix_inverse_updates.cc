@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "test_matrices.hpp"
+
+
+
+/// @brief A well-conditioned 5x5 test matrix and its inverse
+void make_system(tmm::Matrix<5,5,double> &A, tmm::Matrix<5,5,double> &Ainv){
+  for(tmm::Size i = 0; i < 5; i++){
+    for(tmm::Size j = 0; j < 5; j++){
+      A[i][j] = (double)((i*3 + j*5) % 7) / 7.0;
+    }
+    A[i][i] += 4;
+  }
+  ASSERT_TRUE(tmm::refactorInverse(A, Ainv));
+}
+
+
+
+/// @brief Test the Sherman-Morrison update against a full inversion
+TEST(TMMTests, Rank1_Update_Inverse){
+  tmm::Matrix<5,5,double> A, Ainv;
+  make_system(A, Ainv);
+
+  tmm::Matrix<5,1,double> u, v;
+  for(tmm::Size i = 0; i < 5; i++){
+    u[i][0] = 0.5 * i - 1;
+    v[i][0] = 0.25 * i + 0.1;
+  }
+  ASSERT_TRUE(tmm::rank1UpdateInverse(Ainv, u, v));
+
+  tmm::Matrix<5,5,double> expected;
+  ASSERT_TRUE(tmm::refactorInverse(A + u * v.transpose(), expected));
+  ASSERT_TRUE(matrices_near(Ainv, expected, 1e-12));
+}
+
+
+
+/// @brief Test the Woodbury update against a full inversion
+TEST(TMMTests, RankK_Update_Inverse){
+  tmm::Matrix<5,5,double> A, Ainv;
+  make_system(A, Ainv);
+
+  tmm::Matrix<5,2,double> U, V;
+  for(tmm::Size i = 0; i < 5; i++){
+    U[i][0] = 0.5 * i - 1;  U[i][1] = (i % 2) ? 0.3 : -0.2;
+    V[i][0] = 0.25 * i;     V[i][1] = 1.0 / (i + 1);
+  }
+  ASSERT_TRUE(tmm::rankKUpdateInverse(Ainv, U, V));
+
+  tmm::Matrix<5,5,double> expected;
+  ASSERT_TRUE(tmm::refactorInverse(A + U * V.transpose(), expected));
+  ASSERT_TRUE(matrices_near(Ainv, expected, 1e-12));
+}
+
+
+
+/// @brief Test that an update that makes the matrix singular is rejected and handled
+TEST(TMMTests, Rank1_Update_Inverse_Unstable){
+  tmm::Matrix<2,2,double> A = tmm::Identity<2,double>();
+  tmm::Matrix<2,2,double> Ainv = tmm::Identity<2,double>();
+  tmm::Matrix<2,1,double> u, v;
+  u[0][0] = -1;
+  v[0][0] = 1;
+
+  // I + u*v^T is singular, so the update must be rejected and Ainv left unchanged
+  ASSERT_FALSE(tmm::rank1UpdateInverse(Ainv, u, v));
+  ASSERT_TRUE(matrices_near(Ainv, tmm::Identity<2,double>(), 0));
+
+  // The refactoring variant also reports the singular result
+  ASSERT_FALSE(tmm::rank1UpdateInverse(A, Ainv, u, v));
+
+  // A nearly singular update falls back to refactoring and stays accurate
+  A = tmm::Identity<2,double>();
+  Ainv = tmm::Identity<2,double>();
+  u[0][0] = -1 + 1e-9;
+  ASSERT_TRUE(tmm::rank1UpdateInverse(A, Ainv, u, v));
+  ASSERT_TRUE(matrices_near(A * Ainv, tmm::Identity<2,double>(), 1e-6));
+}
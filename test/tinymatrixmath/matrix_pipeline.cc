@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+
+
+
+/// @brief Push and pop through a small ring many times, so the positions wrap around
+TEST(TMMTests, Ring_Buffer_Wraparound){
+  tmm::RingBuffer<tmm::Matrix<2,1>> ring(3);
+  ASSERT_EQ(ring.capacity(), 4u);
+
+  int pushed = 0, popped = 0;
+  for(int round = 0; round < 50; round++){
+    // Fill the ring in one batch
+    const std::size_t free = ring.writable(ring.capacity());
+    for(std::size_t i = 0; i < free; i++) ring.writeSlot(i) = (float)(pushed + (int)i);
+    ring.publish(free);
+    pushed += (int)free;
+    tmm::Matrix<2,1> extra;
+    ASSERT_FALSE(ring.tryPush(extra));
+
+    // Drain part of it, one frame at a time
+    for(int i = 0; i < 3; i++){
+      tmm::Matrix<2,1> frame;
+      ASSERT_TRUE(ring.tryPop(frame));
+      ASSERT_EQ(frame[1][0], (float)popped++);
+    }
+  }
+  ASSERT_EQ(ring.readable(), (std::size_t)(pushed - popped));
+  ASSERT_FALSE(ring.closed());
+  ring.close();
+  ASSERT_TRUE(ring.closed());
+}
+
+
+
+#ifdef TMM_ENABLE_THREADS
+/// @brief Run frames through three stages and check that every frame arrives, in order
+TEST(TMMTests, Pipeline_Order_And_Filtering){
+  for(std::size_t batch : {1, 5, 16}){
+    tmm::Pipeline pipeline(8, batch);
+
+    int next = 0;
+    auto &raw = pipeline.source<tmm::Matrix<3,1>>("source", [&](tmm::Matrix<3,1> &frame){
+      if(next == 1000) return false;
+      frame = (float)next++;
+      return true;
+    });
+    // Drops every third frame and doubles the rest
+    auto &doubled = pipeline.stage<tmm::Matrix<1,3>>("double", raw, [](const tmm::Matrix<3,1> &in, tmm::Matrix<1,3> &out){
+      if((int)in.data[0][0] % 3 == 0) return false;
+      out = in.transpose() * 2.0f;
+      return true;
+    });
+    std::vector<float> received;
+    pipeline.sink("sink", doubled, [&](const tmm::Matrix<1,3> &frame){ received.push_back(frame.data[0][2]); });
+
+    ASSERT_TRUE(pipeline.start());
+    ASSERT_FALSE(pipeline.start());
+    pipeline.wait();
+
+    std::vector<float> expected;
+    for(int i = 0; i < 1000; i++) if(i % 3) expected.push_back(2.0f * i);
+    ASSERT_EQ(received, expected);
+
+    std::vector<tmm::PipelineStageStats> stats = pipeline.stats();
+    ASSERT_EQ(stats.size(), 3u);
+    ASSERT_EQ(stats[0].name, "source");
+    ASSERT_EQ(stats[0].frames, 1000u);
+    ASSERT_EQ(stats[1].frames, 1000u);
+    ASSERT_EQ(stats[1].dropped, 334u);
+    ASSERT_EQ(stats[2].frames, expected.size());
+    ASSERT_GT(stats[2].throughput, 0);
+    ASSERT_GE(stats[2].maxLatency, stats[2].meanLatency);
+  }
+}
+
+
+/// @brief A slow sink must hold the source back instead of losing frames
+TEST(TMMTests, Pipeline_Backpressure_And_Stop){
+  tmm::Pipeline pipeline(2);
+  std::atomic<int> produced{0};
+  auto &raw = pipeline.source<tmm::Matrix<1,1>>("endless", [&](tmm::Matrix<1,1> &frame){
+    frame = (float)produced++;
+    return true;
+  });
+  int consumed = 0;
+  bool in_order = true;
+  pipeline.sink("slow", raw, [&](const tmm::Matrix<1,1> &frame){
+    in_order = in_order && frame.data[0][0] == (float)consumed;
+    consumed++;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  });
+
+  ASSERT_TRUE(pipeline.start());
+  while(pipeline.stats()[1].frames < 50) std::this_thread::yield();
+  pipeline.stop();
+  pipeline.wait();
+
+  // Everything produced was consumed, and the source was never more than the ring's size ahead
+  ASSERT_TRUE(in_order);
+  ASSERT_EQ(consumed, produced.load());
+  ASSERT_GT(pipeline.stats()[0].stalls, 0u);
+}
+
+
+/// @brief A stage waiting on a slow source sleeps instead of spinning
+TEST(TMMTests, Pipeline_Idle_Stage_Sleeps){
+  tmm::Pipeline pipeline;
+  bool first = true;
+  auto &raw = pipeline.source<tmm::Matrix<1,1>>("slow", [&](tmm::Matrix<1,1> &frame){
+    if(!first) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    frame = 1.0f;
+    first = false;
+    return true;
+  });
+  int consumed = 0;
+  pipeline.sink("idle", raw, [&](const tmm::Matrix<1,1> &){ consumed++; });
+
+  ASSERT_TRUE(pipeline.start());
+  pipeline.wait();
+  ASSERT_EQ(consumed, 1);
+
+  // 64 spins and 64 yields, then sleeps of up to 1 ms: a few hundred checks in 200 ms, where spinning takes millions
+  const tmm::PipelineStageStats sink = pipeline.stats()[1];
+  ASSERT_GT(sink.waits, 128u);
+  ASSERT_LT(sink.waits, 1000u);
+}
+
+
+/// @brief A link nobody reads from would fill up and stall the pipeline, so start() refuses it
+TEST(TMMTests, Pipeline_Unconsumed_Link){
+  tmm::Pipeline pipeline;
+  pipeline.source<tmm::Matrix<1,1>>("source", [](tmm::Matrix<1,1> &){ return false; });
+  ASSERT_FALSE(pipeline.start());
+}
+#endif
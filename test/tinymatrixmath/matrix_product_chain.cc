@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "float_eq.hpp"
+
+
+
+/// @brief Check that the cheapest order is found at compile time
+TEST(TMMTests, Product_Chain_Order){
+  // A * B * v with 6x6 A and B: A * (B * v) takes 72 multiply-adds instead of 252
+  typedef tmm::ProductChain<float, 6, 6, 6, 1> MatrixMatrixVector;
+  ASSERT_EQ(MatrixMatrixVector::cost, 72ul);
+  ASSERT_EQ((tmm::ChainOrder<0, 2, 6, 6, 6, 1>::split), 0);
+
+  // The textbook example: 30x35, 35x15, 15x5, 5x10, 10x20 and 20x25, best as (A1 (A2 A3)) ((A4 A5) A6)
+  typedef tmm::ChainOrder<0, 5, 30, 35, 15, 5, 10, 20, 25> Textbook;
+  ASSERT_EQ(Textbook::cost, 15125ul);
+  ASSERT_EQ(Textbook::split, 2);
+  ASSERT_EQ((tmm::ChainOrder<0, 2, 30, 35, 15, 5, 10, 20, 25>::split), 0);
+  ASSERT_EQ((tmm::ChainOrder<3, 5, 30, 35, 15, 5, 10, 20, 25>::split), 4);
+}
+
+
+/// @brief Evaluate chains and compare them against left-to-right products
+TEST(TMMTests, Product_Chain_Evaluation){
+  // Small integers, so every order gives exactly the same result
+  tmm::Matrix<6,6> A, B;
+  tmm::Matrix<6,1> v;
+  tmm::Matrix<1,4> w;
+  for(tmm::Size i = 0; i < 6; i++){
+    for(tmm::Size j = 0; j < 6; j++){
+      A[i][j] = (float)((i*7 + j*3) % 5) - 2;
+      B[i][j] = (float)((i*2 + j*5) % 7) - 3;
+    }
+    v[i][0] = (float)i - 1;
+  }
+  for(tmm::Size j = 0; j < 4; j++) w[0][j] = (float)j + 1;
+
+  tmm::Matrix<6,1> Bv = tmm::chain(A) * B * v;
+  ASSERT_TRUE(Bv == A * B * v);
+
+  tmm::Matrix<6,4> outer = tmm::chain(A) * B * v * w;
+  ASSERT_TRUE(outer == A * B * v * w);
+
+  tmm::Matrix<6,4> evaluated;
+  evaluated = 5;
+  (tmm::chain(A) * B * v * w).evaluateTo(evaluated);
+  ASSERT_TRUE(evaluated == outer);
+
+  // A chain of one matrix is a copy, and temporaries can be factors
+  tmm::Matrix<6,6> single = tmm::chain(A);
+  ASSERT_TRUE(single == A);
+  tmm::Matrix<1,1> quadratic = tmm::chain(v.transpose()) * (A + B) * v;
+  ASSERT_TRUE(quadratic == v.transpose() * (A + B) * v);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+
+#include <random>
+
+
+
+/// @brief Fills an int8 matrix with random values, including the extremes -128 and 127
+template<tmm::Size n, tmm::Size m>
+tmm::Matrix<n,m,int8_t> random_int8(std::mt19937 &rng){
+  std::uniform_int_distribution<int> dist(-128, 127);
+  tmm::Matrix<n,m,int8_t> A;
+  for(tmm::Size i = 0; i < n; i++) for(tmm::Size j = 0; j < m; j++) A.data[i][j] = (int8_t)dist(rng);
+  A.data[0][0] = -128;
+  A.data[n-1][m-1] = 127;
+  return A;
+}
+
+template<tmm::Size n, tmm::Size m>
+tmm::Matrix<n,m> random_float(std::mt19937 &rng, float lo, float hi){
+  std::uniform_real_distribution<float> dist(lo, hi);
+  tmm::Matrix<n,m> A;
+  for(tmm::Size i = 0; i < n; i++) for(tmm::Size j = 0; j < m; j++) A.data[i][j] = dist(rng);
+  return A;
+}
+
+
+
+/// @brief The fixed-point scale rounds like the real product
+TEST(TMMTests, Quantized_FixedPointScale){
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<int32_t> values(-1000000, 1000000);
+  for(double real : {1e-6, 0.0003, 0.017, 0.25, 0.5, 0.999, 1.0, 3.7}){
+    const tmm::FixedPointScale s = tmm::fixedPointScale(real);
+    for(int t = 0; t < 1000; t++){
+      const int32_t x = values(rng);
+      const double exact = x * real;
+      ASSERT_LE(fabs(tmm::applyScale(x, s) - exact), 0.5 + 1e-6 * fabs(exact)) << real << " * " << x;
+    }
+  }
+  ASSERT_EQ(tmm::applyScale(12345, tmm::fixedPointScale(0)), 0);
+}
+
+
+/// @brief The SIMD dot product matches the plain loop for every length, including the remainders
+TEST(TMMTests, Quantized_Dot){
+  std::mt19937 rng(2);
+  const tmm::Matrix<2,100,int8_t> V = random_int8<2,100>(rng);
+  for(int count = 0; count <= 100; count++){
+    int32_t expected = 0;
+    for(int k = 0; k < count; k++) expected += V.data[0][k] * V.data[1][k];
+    ASSERT_EQ(tmm::dotInt8(V.data[0], V.data[1], count), expected) << count;
+  }
+
+  // The largest possible sum of products does not overflow
+  int8_t a[255], b[255];
+  for(int k = 0; k < 255; k++) a[k] = b[k] = -128;
+  ASSERT_EQ(tmm::dotInt8(a, b, 255), 255 * 16384);
+}
+
+
+/// @brief The int32 product is exact
+TEST(TMMTests, Quantized_MultiplyInt32){
+  std::mt19937 rng(3);
+  const tmm::Matrix<7,37,int8_t> A = random_int8<7,37>(rng);
+  const tmm::Matrix<37,5,int8_t> B = random_int8<37,5>(rng);
+  const tmm::Matrix<7,5,int32_t> C = tmm::multiplyInt32(A, B);
+  for(tmm::Size i = 0; i < 7; i++) for(tmm::Size j = 0; j < 5; j++){
+    int32_t expected = 0;
+    for(tmm::Size k = 0; k < 37; k++) expected += A.data[i][k] * B.data[k][j];
+    ASSERT_EQ(C.data[i][j], expected);
+  }
+}
+
+
+/// @brief A quantized layer relu(W x + bias) matches the float layer to within the rounding of its inputs and output
+TEST(TMMTests, Quantized_Layer){
+  std::mt19937 rng(4);
+  const tmm::Matrix<12,40> W = random_float<12,40>(rng, -0.5f, 0.5f);
+  const tmm::Matrix<40,3> X = random_float<40,3>(rng, 0.0f, 2.0f);
+  const tmm::Matrix<12,1> bias = random_float<12,1>(rng, -1.0f, 1.0f);
+
+  // Float reference
+  tmm::Matrix<12,3> Y = W * X;
+  for(tmm::Size i = 0; i < 12; i++) for(tmm::Size j = 0; j < 3; j++){
+    Y[i][j] += bias.data[i][0];
+    if(Y[i][j] < 0) Y[i][j] = 0;
+  }
+
+  const tmm::Quantization x_quant = tmm::quantizationForRange(0.0f, 2.0f);
+  const tmm::Quantization y_quant = tmm::quantizationForRange(0.0f, 8.0f);
+  const tmm::Matrix<40,3,int8_t> Xq = tmm::quantize(X, x_quant);
+
+  // Asymmetric weights with one quantization for the whole matrix
+  const tmm::Quantization w_quant = tmm::quantizationForRange(-0.5f, 0.6f);
+  const tmm::Matrix<12,40,int8_t> Wq = tmm::quantize(W, w_quant);
+  const tmm::Requantization<12> layer(Wq, w_quant, x_quant, y_quant, &bias.data[0][0], true);
+  const tmm::Matrix<12,3> Y1 = tmm::dequantize(tmm::quantizedMultiply(Wq, Xq, layer), y_quant);
+
+  // Symmetric weights with one quantization per row, and a different range in each row
+  tmm::Matrix<12,40> W2 = W;
+  tmm::Quantization row_quant[12];
+  for(tmm::Size i = 0; i < 12; i++){
+    for(tmm::Size k = 0; k < 40; k++) W2[i][k] *= (float)(i + 1) / 12;
+    row_quant[i].scale = 0.5f * (i + 1) / 12 / 127;
+    row_quant[i].zero = 0;
+  }
+  tmm::Matrix<12,40,int8_t> W2q;
+  for(tmm::Size i = 0; i < 12; i++) for(tmm::Size k = 0; k < 40; k++) W2q[i][k] = tmm::quantizeValue(W2[i][k], row_quant[i]);
+  const tmm::Requantization<12> layer2(W2q, row_quant, x_quant, y_quant, &bias.data[0][0], true);
+  ASSERT_FALSE(layer2.useColumnSums);
+  const tmm::Matrix<12,3> Y2 = tmm::dequantize(tmm::quantizedMultiply(W2q, Xq, layer2), y_quant);
+
+  tmm::Matrix<12,3> Y2_expected = W2 * X;
+  for(tmm::Size i = 0; i < 12; i++) for(tmm::Size j = 0; j < 3; j++){
+    Y2_expected[i][j] += bias.data[i][0];
+    if(Y2_expected[i][j] < 0) Y2_expected[i][j] = 0;
+  }
+
+  // 40 products, each with rounding errors of half a step in both inputs, then half an output step
+  const float tolerance = 40 * 0.5f * (w_quant.scale * 2.0f + x_quant.scale * 0.6f) + y_quant.scale;
+  for(tmm::Size i = 0; i < 12; i++) for(tmm::Size j = 0; j < 3; j++){
+    ASSERT_NEAR(Y1.data[i][j], Y[i][j], tolerance);
+    ASSERT_NEAR(Y2.data[i][j], Y2_expected[i][j], tolerance);
+    ASSERT_GE(Y1.data[i][j], 0.0f);
+  }
+}
+
+
+/// @brief Biases far outside the int32 accumulator range saturate instead of overflowing
+TEST(TMMTests, Quantized_Bias_Saturation){
+  ASSERT_EQ(tmm::roundToInt32(1e12f), INT32_MAX);
+  ASSERT_EQ(tmm::roundToInt32(-1e12f), INT32_MIN);
+  ASSERT_EQ(tmm::roundToInt32(-2.5f), -3);
+  ASSERT_EQ(tmm::quantizeValue(1e30f, {1e-6f, 0}), 127);
+
+  std::mt19937 rng(6);
+  const tmm::Matrix<4,16,int8_t> A = random_int8<4,16>(rng);
+  const tmm::Matrix<16,2,int8_t> B = random_int8<16,2>(rng);
+  const tmm::Quantization a = {0.01f, 5}, b = {0.01f, -3}, out = {0.1f, 0};
+  const float bias[4] = {1e9f, -1e9f, 3e38f, -3e38f};
+  const tmm::Requantization<4> layer(A, a, b, out, bias);
+  // The bias saturates first, then the zero-point terms are added: here they push row 2 up and pull row 3 back in range
+  ASSERT_EQ(layer.offset[2], INT32_MAX);
+  ASSERT_LT(layer.offset[3], INT32_MIN / 2);
+
+  const tmm::Matrix<4,2,int8_t> C = tmm::quantizedMultiply(A, B, layer);
+  for(tmm::Size j = 0; j < 2; j++){
+    ASSERT_EQ(C.data[0][j], 127);
+    ASSERT_EQ(C.data[1][j], -128);
+    ASSERT_EQ(C.data[2][j], 127);
+    ASSERT_EQ(C.data[3][j], -128);
+  }
+}
+
+
+/// @brief Requantization applies the zero points exactly, and ReLU clamps at the output zero point
+TEST(TMMTests, Quantized_ZeroPoints){
+  std::mt19937 rng(5);
+  const tmm::Matrix<4,19,int8_t> A = random_int8<4,19>(rng);
+  const tmm::Matrix<19,2,int8_t> B = random_int8<19,2>(rng);
+  const tmm::Quantization a = {0.02f, 3}, b = {0.05f, -7}, out = {0.5f, -20};
+  const tmm::Matrix<4,2,int8_t> C = tmm::quantizedMultiply(A, B, tmm::Requantization<4>(A, a, b, out));
+  const tmm::Matrix<4,2,int8_t> R = tmm::quantizedMultiply(A, B, tmm::Requantization<4>(A, a, b, out, nullptr, true));
+  for(tmm::Size i = 0; i < 4; i++) for(tmm::Size j = 0; j < 2; j++){
+    int32_t acc = 0;
+    for(tmm::Size k = 0; k < 19; k++) acc += (A.data[i][k] - a.zero) * (B.data[k][j] - b.zero);
+    double expected = acc * (double)a.scale * b.scale / out.scale + out.zero;
+    expected = expected < -128 ? -128 : expected > 127 ? 127 : expected;
+    ASSERT_LE(fabs(C.data[i][j] - expected), 0.5 + 1e-4);
+    ASSERT_EQ(R.data[i][j], C.data[i][j] < out.zero ? out.zero : C.data[i][j]);
+  }
+}
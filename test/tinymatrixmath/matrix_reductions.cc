@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "test_matrices.hpp"
+
+
+
+/// @brief Check the reductions against plain loops on sizes that do and don't fill the accumulator lanes
+TEST(TMMTests, Reductions_Values){
+  const tmm::Matrix<5,7> A = small_integers<5,7>(1);
+  const tmm::Matrix<5,7> B = small_integers<5,7>(4);
+  float sum = 0, dot = 0, largest = A.data[0][0], smallest = A.data[0][0];
+  for(tmm::Size i = 0; i < 5; i++) for(tmm::Size j = 0; j < 7; j++){
+    sum += A.data[i][j];
+    dot += A.data[i][j] * B.data[i][j];
+    if(A.data[i][j] > largest) largest = A.data[i][j];
+    if(A.data[i][j] < smallest) smallest = A.data[i][j];
+  }
+  for(tmm::Summation s : {tmm::Summation::Lanes, tmm::Summation::Kahan, tmm::Summation::Pairwise}){
+    ASSERT_EQ(tmm::sum(A, s), sum);
+    ASSERT_EQ(tmm::dot(A, B, s), dot);
+  }
+  ASSERT_EQ(tmm::squaredNorm(A), tmm::dot(A, A));
+  ASSERT_FLOAT_EQ(tmm::frobeniusNorm(A), sqrtf(tmm::dot(A, A)));
+  ASSERT_EQ(tmm::maxElement(A), largest);
+  ASSERT_EQ(tmm::minElement(A), smallest);
+  ASSERT_EQ(tmm::maxAbs(A), 4.0f);
+
+  // A 3-4-5 vector
+  float v_data[2][1] = {{3},{4}};
+  tmm::Matrix<2,1> v(v_data);
+  ASSERT_FLOAT_EQ(tmm::frobeniusNorm(v), 5.0f);
+
+  float M_data[3][3] = {{ 1, -7,  2},
+                        {-4,  5, -6},
+                        { 3,  8, -9}};
+  tmm::Matrix<3,3> M(M_data);
+  ASSERT_EQ(tmm::trace(M), -3.0f);
+  ASSERT_EQ(tmm::oneNorm(M), 20.0f);      // column 1
+  ASSERT_EQ(tmm::infinityNorm(M), 20.0f); // row 2
+  ASSERT_EQ(tmm::infinityNorm(M.transpose()), tmm::oneNorm(M));
+}
+
+
+/// @brief argmax and argmin report the first of equal elements
+TEST(TMMTests, Reductions_Arg){
+  float M_data[2][3] = {{ 1, 9, -2},
+                        { 9, 0, -2}};
+  tmm::Matrix<2,3> M(M_data);
+  tmm::Size row = 7, col = 7;
+  ASSERT_EQ(tmm::argmax(M, row, col), 9.0f);
+  ASSERT_EQ(row, 0);
+  ASSERT_EQ(col, 1);
+  ASSERT_EQ(tmm::argmin(M, row, col), -2.0f);
+  ASSERT_EQ(row, 0);
+  ASSERT_EQ(col, 2);
+}
+
+
+/// @brief Compensated and pairwise summation keep the small terms that a plain float sum drops
+TEST(TMMTests, Reductions_Accuracy){
+  // One large element and many that are each below its rounding error
+  tmm::Matrix<64,64> A;
+  for(tmm::Size i = 0; i < 64; i++) for(tmm::Size j = 0; j < 64; j++) A[i][j] = 0.1f;
+  A[0][0] = 1e6f;
+  const double exact = 1e6 + 4095 * (double)0.1f;
+
+  float naive = 0;
+  for(tmm::Size i = 0; i < 64; i++) for(tmm::Size j = 0; j < 64; j++) naive += A[i][j];
+  const double naive_error = fabs(naive - exact);
+  const double lanes_error = fabs(tmm::sum(A) - exact);
+  const double pairwise_error = fabs(tmm::sum(A, tmm::Summation::Pairwise) - exact);
+  const double kahan_error = fabs(tmm::sum(A, tmm::Summation::Kahan) - exact);
+
+  ASSERT_GT(naive_error, 10.0);
+  ASSERT_LT(lanes_error, naive_error);
+  ASSERT_LT(pairwise_error, naive_error / 10);
+  ASSERT_LT(kahan_error, 0.1); // within the rounding of the float result
+
+  // The same input always gives the same result
+  ASSERT_EQ(tmm::sum(A), tmm::sum(A));
+}
+
+
+/// @brief The reductions work on dual numbers, so norms can be differentiated
+TEST(TMMTests, Reductions_Dual){
+  typedef tmm::Dual<float,2> D;
+  tmm::Matrix<2,1,D> v;
+  v[0][0] = D::variable(3, 0);
+  v[1][0] = D::variable(4, 1);
+  const D norm = tmm::frobeniusNorm(v);
+  ASSERT_FLOAT_EQ(norm.value, 5.0f);
+  ASSERT_FLOAT_EQ(norm.derivatives[0], 0.6f);
+  ASSERT_FLOAT_EQ(norm.derivatives[1], 0.8f);
+}
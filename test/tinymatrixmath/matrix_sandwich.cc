@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "float_eq.hpp"
+
+
+
+/// @brief Test A*P*A^T + Q against the unfused expression and check exact symmetry
+TEST(TMMTests, Sandwich_Product){
+  const float F_raw[3][2] = {
+    {1, 0.1f},
+    {0, 1},
+    {0.5f, -2}
+  };
+  const float P_raw[2][2] = {
+    {2, 0.3f},
+    {0.3f, 1}
+  };
+  tmm::Matrix<3,2> F(F_raw);
+  tmm::Matrix<2,2> P(P_raw);
+  tmm::Matrix<3,3> Q = tmm::Identity<3>() * 0.01f;
+
+  tmm::Matrix<3,3> expected = F * P * F.transpose() + Q;
+  tmm::Matrix<3,3> result = tmm::sandwich(F, P, Q);
+
+  for(tmm::Size i = 0; i < 3; i++){
+    for(tmm::Size j = 0; j < 3; j++){
+      ASSERT_TRUE(float_eq(result[i][j], expected[i][j]));
+      ASSERT_EQ(result[i][j], result[j][i]);
+    }
+  }
+
+  // Without Q, and accumulating into an existing matrix
+  tmm::Matrix<3,3> accumulated = Q;
+  tmm::sandwichAccumulate(F, P, accumulated);
+  tmm::Matrix<3,3> without_Q = tmm::sandwich(F, P);
+  for(tmm::Size i = 0; i < 3; i++){
+    for(tmm::Size j = 0; j < 3; j++){
+      ASSERT_EQ(accumulated[i][j], result[i][j]);
+      ASSERT_TRUE(float_eq(without_Q[i][j], expected[i][j] - Q[i][j]));
+    }
+  }
+
+  // Accumulating into P itself, as in P += F*P*F^T
+  tmm::Matrix<3,3> G = F * F.transpose() + Q;
+  tmm::Matrix<3,3> R = tmm::Identity<3>() + Q;
+  const tmm::Matrix<3,3> R_expected = tmm::sandwich(G, R, R);
+  tmm::sandwichAccumulate(G, R, R);
+  // ...and into A, as in A += A*P*A^T
+  const tmm::Matrix<3,3> G_expected = tmm::sandwich(G, R, G);
+  tmm::sandwichAccumulate(G, R, G);
+  for(tmm::Size i = 0; i < 3; i++){
+    for(tmm::Size j = 0; j < 3; j++){
+      ASSERT_EQ(R[i][j], R_expected.data[i][j]);
+      ASSERT_EQ(G[i][j], G_expected.data[i][j]);
+    }
+  }
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "TinyMatrixMath.hpp"
+#include "test_matrices.hpp"
+
+
+
+/// @brief Zeroes the elements of a dense matrix outside a pattern
+template<tmm::Size n, tmm::Size m>
+tmm::Matrix<n,m> masked(tmm::Matrix<n,m> A, const tmm::SparsityPattern<n,m> &pattern){
+  for(tmm::Size i = 0; i < n; i++) for(tmm::Size j = 0; j < m; j++) if(!tmm::patternHas(pattern, i*m + j)) A[i][j] = 0;
+  return A;
+}
+
+
+constexpr tmm::SparsityPattern<6,6> blocks = tmm::blockPattern<6,6>(0, 0, 3, 3) | tmm::blockPattern<6,6>(3, 3, 3, 3);
+// A measurement Jacobian that only sees position (columns 0..2) and one rate (column 4)
+constexpr tmm::SparsityPattern<3,6> measurement = tmm::blockPattern<3,6>(0, 0, 3, 3) | tmm::blockPattern<3,6>(0, 4, 3, 1);
+// Three 4x4 blocks in a 12x12 matrix, over three words with blocks that straddle them
+constexpr tmm::SparsityPattern<12,12> large_blocks =
+  tmm::blockPattern<12,12>(0, 0, 4, 4) | tmm::blockPattern<12,12>(4, 4, 4, 4) | tmm::blockPattern<12,12>(8, 8, 4, 4);
+// Patterns with more elements than the compiler's template depth limit, and rows that straddle words
+constexpr tmm::SparsityPattern<32,32> diagonal_32 = tmm::diagonalPattern<32,32>();
+constexpr tmm::SparsityPattern<40,30> wide_a = tmm::diagonalPattern<40,30>() | tmm::blockPattern<40,30>(10, 5, 20, 7);
+constexpr tmm::SparsityPattern<30,50> wide_b = tmm::blockPattern<30,50>(0, 0, 8, 50) | tmm::blockPattern<30,50>(6, 20, 24, 3);
+
+
+
+/// @brief Check the compile-time pattern arithmetic
+TEST(TMMTests, Sparse_Patterns){
+  static_assert(tmm::patternCount(blocks) == 18, "two 3x3 blocks");
+  static_assert(tmm::patternIndex(blocks, 3*6 + 3) == 9, "first element of the second block");
+  static_assert(tmm::diagonalPattern<2,3>().word[0] == ((1ull << 0) | (1ull << 4)), "diagonal of a 2x3 matrix");
+  static_assert(tmm::transposePattern(tmm::blockPattern<2,3>(0, 1, 1, 2)).word[0] == ((1ull << 2) | (1ull << 4)), "row to column");
+
+  // The product of the block-diagonal pattern with itself is itself
+  static_assert(tmm::productPattern(blocks, blocks) == blocks, "block-diagonal products stay block-diagonal");
+  // A diagonal times anything keeps the other pattern
+  static_assert(tmm::productPattern(tmm::diagonalPattern<3,3>(), measurement) == measurement, "diagonal scaling");
+
+  // Patterns of more than 64 elements span several words
+  static_assert(tmm::SparsityPattern<12,12>::words == 3, "144 elements");
+  static_assert(tmm::patternCount(large_blocks) == 48, "three 4x4 blocks");
+  static_assert(tmm::patternIndex(large_blocks, 8*12 + 8) == 32, "first element of the third block, in the second word");
+  static_assert(large_blocks.has(5*12 + 6) && !large_blocks.has(5*12 + 8), "row 5 is in the second block");
+  static_assert(tmm::transposePattern(large_blocks) == large_blocks, "block-diagonal patterns are symmetric");
+  static_assert(tmm::productPattern(large_blocks, large_blocks) == large_blocks, "and closed under products");
+  typedef tmm::SparseStaticMatrix<6,6,blocks> Blocks;
+  ASSERT_EQ(Blocks::count, 18);
+  ASSERT_EQ(sizeof(Blocks), 18 * sizeof(float));
+  ASSERT_TRUE(Blocks::isNonzero(4, 5));
+  ASSERT_FALSE(Blocks::isNonzero(2, 3));
+}
+
+
+/// @brief Compare sparse products with dense products
+TEST(TMMTests, Sparse_Products){
+  const tmm::Matrix<6,6> F_dense = masked(small_integers<6,6>(1), blocks);
+  const tmm::Matrix<3,6> H_dense = masked(small_integers<3,6>(2), measurement);
+  const tmm::Matrix<6,6> P = small_integers<6,6>(3);
+  const tmm::Matrix<6,1> x = small_integers<6,1>(4);
+
+  // Entries outside the pattern are dropped when converting
+  const tmm::SparseStaticMatrix<6,6,blocks> F(small_integers<6,6>(1));
+  const tmm::SparseStaticMatrix<3,6,measurement> H(H_dense);
+  ASSERT_TRUE(F.dense() == F_dense);
+  ASSERT_EQ(F.get(1, 2), F_dense.data[1][2]);
+  ASSERT_EQ(F.get(1, 4), 0);
+
+  // Sparse times dense and dense times sparse
+  ASSERT_TRUE(F * x == F_dense * x);
+  ASSERT_TRUE(H * P == H_dense * P);
+  ASSERT_TRUE(P * H.transpose() == P * H_dense.transpose());
+  ASSERT_TRUE(H.transpose().dense() == H_dense.transpose());
+
+  // Sparse times sparse: H F keeps only the columns that reach the measurement
+  const auto HF = H * F;
+  ASSERT_EQ(HF.count, 18);
+  ASSERT_TRUE(HF.dense() == H_dense * F_dense);
+  const auto FF = F * F;
+  ASSERT_TRUE(FF.dense() == F_dense * F_dense);
+
+  // Writing through the compile-time accessor
+  tmm::SparseStaticMatrix<6,6,blocks> G = F;
+  G.at<4,5>() = 100;
+  ASSERT_EQ(G.dense()[4][5], 100);
+}
+
+
+/// @brief Compare sparse products with dense products for a pattern larger than one word
+TEST(TMMTests, Sparse_Products_Large){
+  const tmm::Matrix<12,12> F_dense = masked(small_integers<12,12>(5), large_blocks);
+  const tmm::Matrix<12,12> P = small_integers<12,12>(6);
+  const tmm::Matrix<12,1> x = small_integers<12,1>(7);
+
+  const tmm::SparseStaticMatrix<12,12,large_blocks> F(F_dense);
+  ASSERT_EQ(sizeof(F), 48 * sizeof(float));
+  ASSERT_TRUE(F.dense() == F_dense);
+  ASSERT_EQ(F.get(9, 11), F_dense.data[9][11]);
+  ASSERT_EQ(F.get(3, 4), 0);
+
+  ASSERT_TRUE(F * x == F_dense * x);
+  ASSERT_TRUE(F * P == F_dense * P);
+  ASSERT_TRUE(P * F == P * F_dense);
+  ASSERT_TRUE(F.transpose().dense() == F_dense.transpose());
+  ASSERT_TRUE((F * F).dense() == F_dense * F_dense);
+}
+
+
+/// @brief Sparse matrices of more than a thousand elements, and a product whose rows straddle the words of its pattern
+TEST(TMMTests, Sparse_Products_Many_Elements){
+  tmm::Matrix<32,32> D_dense;
+  for(tmm::Size i = 0; i < 32; i++) D_dense[i][i] = (float)(i % 5) - 2;
+  const tmm::SparseStaticMatrix<32,32,diagonal_32> D(D_dense);
+  const tmm::Matrix<32,3> x = small_integers<32,3>(8);
+  ASSERT_EQ(D.count, 32);
+  ASSERT_TRUE(D * x == D_dense * x);
+  ASSERT_TRUE((D * D).dense() == D_dense * D_dense);
+
+  const tmm::Matrix<40,30> A_dense = masked(small_integers<40,30>(9), wide_a);
+  const tmm::Matrix<30,50> B_dense = masked(small_integers<30,50>(10), wide_b);
+  const tmm::SparseStaticMatrix<40,30,wide_a> A(A_dense);
+  const tmm::SparseStaticMatrix<30,50,wide_b> B(B_dense);
+  const auto AB = A * B;
+  ASSERT_TRUE(AB.dense() == A_dense * B_dense);
+
+  // The product pattern is exactly the (i,j) that some k connects
+  for(int i = 0; i < 40; i++) for(int j = 0; j < 50; j++){
+    bool connected = false;
+    for(int k = 0; k < 30; k++) connected = connected || (wide_a.has(i*30 + k) && wide_b.has(k*50 + j));
+    ASSERT_EQ(AB.isNonzero(i, j), connected);
+  }
+}
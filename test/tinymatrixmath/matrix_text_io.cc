@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "TinyMatrixMath.hpp"
+
+
+
+const float A_raw[2][3] = {
+  {1, -2.5f, 0.1f},
+  {3e-8f, 1e10f, -0.0f}
+};
+
+
+
+/// @brief Test the text produced for each layout
+TEST(TMMTests, Text_Layouts){
+  const float B_raw[2][2] = {
+    {1, -2.5f},
+    {0.125f, 4}
+  };
+  tmm::Matrix<2,2> B(B_raw);
+
+  std::ostringstream tsv, csv, json, fixed;
+  B.printTo(tsv);
+  B.printTo(csv, tmm::TextFormat(tmm::TextLayout::CSV));
+  B.printTo(json, tmm::TextFormat(tmm::TextLayout::JSON));
+  B.printTo(fixed, tmm::TextFormat(tmm::TextLayout::TSV, 2));
+
+  ASSERT_EQ(tsv.str(),   "1\t-2.5\n0.125\t4\n");
+  ASSERT_EQ(csv.str(),   "1,-2.5\n0.125,4\n");
+  ASSERT_EQ(json.str(),  "[[1,-2.5],[0.125,4]]\n");
+  ASSERT_EQ(fixed.str(), "1.00\t-2.50\n0.12\t4.00\n");
+}
+
+
+
+/// @brief A helper function that writes a matrix in a layout and reads it back exactly
+void test_round_trip(tmm::TextLayout layout){
+  tmm::Matrix<2,3> A(A_raw);
+  std::stringstream text;
+  {
+    tmm::TextWriter writer(text);
+    for(int i = 0; i < 3; i++) A.formatTo(writer, tmm::TextFormat(layout));
+  }
+
+  tmm::TextReader reader(text);
+  for(int i = 0; i < 3; i++){
+    tmm::Matrix<2,3> B;
+    ASSERT_TRUE(B.readFrom(reader));
+    ASSERT_TRUE(B == A);
+  }
+  tmm::Matrix<2,3> C;
+  ASSERT_FALSE(C.readFrom(reader));
+}
+
+
+
+/// @brief Test that the shortest representation reads back to the same values in every layout
+TEST(TMMTests, Text_Round_Trip){
+  test_round_trip(tmm::TextLayout::TSV);
+  test_round_trip(tmm::TextLayout::CSV);
+  test_round_trip(tmm::TextLayout::JSON);
+}
+
+
+
+/// @brief Test that the reader handles numbers split across refills of a tiny buffer
+TEST(TMMTests, Text_Reader_Small_Buffer){
+  std::stringstream text;
+  for(int i = 0; i < 200; i++) text << (i * 1.25 - 100) << (i % 7 ? "," : "\n");
+
+  // 8 bytes hold at most one or two numbers, so most of them straddle a refill
+  tmm::TextReader reader(text, 8);
+  double value;
+  for(int i = 0; i < 200; i++){
+    ASSERT_TRUE(reader.next(value));
+    ASSERT_EQ(value, i * 1.25 - 100);
+  }
+  ASSERT_FALSE(reader.next(value));
+
+  // A number as long as the buffer is rejected rather than read in pieces
+  std::stringstream long_text("1.5,12345.75,2");
+  tmm::TextReader short_reader(long_text, 8);
+  ASSERT_TRUE(short_reader.next(value));
+  ASSERT_EQ(value, 1.5);
+  ASSERT_FALSE(short_reader.next(value));
+}
+
+
+
+/// @brief Test that a writer with a tiny buffer, or with storage on the stack, writes the same text
+TEST(TMMTests, Text_Writer_Small_Buffer){
+  tmm::Matrix<3,4,double> M;
+  for(int i = 0; i < 3; i++) for(int j = 0; j < 4; j++) M[i][j] = (i - 1.5) / (j + 3.0) * 1e5;
+
+  std::stringstream large, tiny, stack;
+  {
+    tmm::TextWriter writer(large);
+    M.formatTo(writer);
+  }
+  {
+    // Smaller than any of the numbers, which are then formatted on the side
+    tmm::TextWriter writer(tiny, 4);
+    M.formatTo(writer);
+  }
+  {
+    char storage[16];
+    tmm::TextWriter writer(stack, storage, sizeof(storage));
+    M.formatTo(writer);
+  }
+  ASSERT_EQ(tiny.str(), large.str());
+  ASSERT_EQ(stack.str(), large.str());
+
+  // Storage with no room is left alone
+  std::stringstream unbuffered;
+  char untouched[4] = {'x', 'x', 'x', 'x'};
+  {
+    tmm::TextWriter writer(unbuffered, untouched, 0);
+    M.formatTo(writer);
+  }
+  ASSERT_EQ(unbuffered.str(), large.str());
+  for(char c : untouched) ASSERT_EQ(c, 'x');
+}
+
+
+
+/// @brief Test that the reader stops at text that isn't a number
+TEST(TMMTests, Text_Reader_Invalid){
+  std::stringstream text("1, 2, oops, 4");
+  tmm::TextReader reader(text);
+  tmm::Matrix<2,2> M;
+  ASSERT_FALSE(M.readFrom(reader));
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "TinyMatrixMath.hpp"
+
+/// @brief Returns true if two matrices are elementwise equal within a tolerance
+template<tmm::Size n, tmm::Size m>
+bool matrices_near(const tmm::Matrix<n,m,double> &A, const tmm::Matrix<n,m,double> &B, double tolerance){
+  return A.equals(B, tolerance);
+}
+
+/// @brief Fills a matrix with small integers so sums and products are exact in floating point
+template<tmm::Size n, tmm::Size m>
+tmm::Matrix<n,m> small_integers(int seed){
+  tmm::Matrix<n,m> A;
+  for(tmm::Size i = 0; i < n; i++) for(tmm::Size j = 0; j < m; j++) A[i][j] = (float)((i*5 + j*3 + seed) % 9) - 4;
+  return A;
+}